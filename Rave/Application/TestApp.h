@@ -10,11 +10,7 @@ private:
 	void Update(const rv::Duration dt) override;
 
 private:
-	struct Triangle
-	{
-		rv::Shape shape;
-		rv::Shape::Data* data = nullptr;
-	} triangle;
+	rv::Shape triangle;
 	rv::Timer frameTimer;
 	rv::uint frames = 0;
 	rv::Timer timer;
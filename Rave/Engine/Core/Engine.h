@@ -1,6 +1,7 @@
 #pragma once
 #include "Engine/Utility/Result.h"
 #include "Engine/Utility/Multimap.h"
+#include "Engine/Utility/JobSystem.h"
 #include "Engine/Graphics/Graphics.h"
 #include "Engine/Graphics/WindowRenderer.h"
 
@@ -17,6 +18,7 @@ namespace rv
 		static Result Create(Engine& engine, const Surface& surface);
 		static Result Create(Engine& engine, const Window& window);
 
+		JobSystem jobs;
 		Graphics graphics;
 	};
 }
\ No newline at end of file
@@ -57,6 +57,8 @@ namespace rv
 		MouseMovedEvent();
 		MouseMovedEvent(const Point& position, Flags<MouseButton> pressedButtons);
 
+		static void Coalesce(MouseMovedEvent& pending, const MouseMovedEvent& event);
+
 		Point position;
 		Flags<MouseButton> pressedButtons;
 	};
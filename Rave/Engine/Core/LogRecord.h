@@ -0,0 +1,201 @@
+#pragma once
+#include "Engine/Utility/Types.h"
+#include "Engine/Utility/Identifier.h"
+#include "Engine/Utility/Result.h"
+#include <chrono>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <cstring>
+#include <cstdio>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace rv
+{
+	enum LogArgumentType : u8
+	{
+		RV_LOG_ARG_INT,
+		RV_LOG_ARG_UINT,
+		RV_LOG_ARG_FLOAT,
+		RV_LOG_ARG_BOOL,
+		RV_LOG_ARG_CHAR,
+		RV_LOG_ARG_STRING,
+		RV_LOG_ARG_POINTER,
+	};
+
+	namespace detail
+	{
+		consteval size_t log_argument_count(const char* format)
+		{
+			size_t count = 0;
+			for (; *format; ++format)
+				if (format[0] == '{' && format[1] == '}')
+					++count;
+			return count;
+		}
+	}
+
+	/*
+		Format string checked and hashed at compile time, every "{}" is replaced by the next argument.
+	*/
+	template<typename... Args>
+	struct BasicLogFormat
+	{
+		template<size_t N>
+		consteval BasicLogFormat(const char (&text)[N])
+			:
+			text(text),
+			id(text)
+		{
+			if (detail::log_argument_count(text) != sizeof...(Args))
+				throw "rv_logf: the number of arguments doesn't match the format string";
+		}
+
+		const char* text;
+		Identifier32 id;
+	};
+
+	template<typename... Args>
+	using LogFormat = BasicLogFormat<std::type_identity_t<Args>...>;
+
+	/*
+		A log message before formatting: the format id plus the raw argument bytes.
+		Strings are copied and truncated when the record runs out of space.
+	*/
+	struct LogRecord
+	{
+		static constexpr size_t max_data = 200;
+
+		template<typename... Args>
+		static void Encode(LogRecord& record, Severity severity, const LogFormat<Args...>& format, const Args&... args)
+		{
+			record.format = format.text;
+			record.id = format.id.hash();
+			record.severity = severity;
+			record.argumentCount = 0;
+			record.size = 0;
+			record.ticks = (u64)std::chrono::steady_clock::now().time_since_epoch().count();
+			(record.Append(args), ...);
+		}
+
+		template<typename T>
+		void Append(const T& value)
+		{
+			typedef std::decay_t<T> D;
+			if constexpr (std::is_same_v<D, bool>)
+				Append(RV_LOG_ARG_BOOL, (u8)value);
+			else if constexpr (std::is_same_v<D, char>)
+				Append(RV_LOG_ARG_CHAR, value);
+			else if constexpr (std::is_enum_v<D>)
+				Append(static_cast<std::underlying_type_t<D>>(value));
+			else if constexpr (std::is_integral_v<D> && std::is_signed_v<D>)
+				Append(RV_LOG_ARG_INT, (i64)value);
+			else if constexpr (std::is_integral_v<D>)
+				Append(RV_LOG_ARG_UINT, (u64)value);
+			else if constexpr (std::is_floating_point_v<D>)
+				Append(RV_LOG_ARG_FLOAT, (double)value);
+			else if constexpr (std::is_same_v<D, const char*> || std::is_same_v<D, char*>)
+				AppendString(value ? std::string_view(value) : std::string_view("(null)"));
+			else if constexpr (std::is_convertible_v<const D&, std::string_view>)
+				AppendString(std::string_view(value));
+			else if constexpr (std::is_pointer_v<D>)
+				Append(RV_LOG_ARG_POINTER, (u64)(uintptr_t)value);
+			else
+				static_assert(!sizeof(D), "Unsupported rv_logf argument type");
+		}
+
+		std::string Format() const;
+
+		const char* format = nullptr;	// only valid inside the process that logged the record
+		u32 id = 0;
+		Severity severity = RV_SEVERITY_INFO;
+		u8 argumentCount = 0;
+		u16 size = 0;
+		u64 ticks = 0;
+		u8 data[max_data];
+
+	private:
+		template<typename T>
+		void Append(LogArgumentType type, const T& value)
+		{
+			if (size + 1 + sizeof(T) > max_data)
+				return;
+			data[size++] = type;
+			std::memcpy(data + size, &value, sizeof(T));
+			size += (u16)sizeof(T);
+			++argumentCount;
+		}
+		void AppendString(std::string_view string);
+	};
+
+	std::string FormatLogMessage(Severity severity, std::chrono::system_clock::time_point time, const std::string& message, const char* date_fmt = "%H:%M:%S");
+
+	/*
+		Binary log layout: a LogFileHeader followed by entries.
+		A format entry (u32 id, u16 length, text) is written the first time a format id is used,
+		a record entry (u32 id, u8 severity, u8 argument count, u16 size, u64 ticks, data) for every message.
+	*/
+	struct LogFileHeader
+	{
+		static LogFileHeader Now();
+		std::chrono::system_clock::time_point Time(u64 ticks) const;
+
+		char magic[4] = { 'R', 'V', 'L', 'G' };
+		u32 version = 1;
+		i64 anchorTicks = 0;
+		i64 anchorSystem = 0;	// system_clock nanoseconds since epoch at anchorTicks
+		i64 periodNum = std::chrono::steady_clock::period::num;
+		i64 periodDen = std::chrono::steady_clock::period::den;
+	};
+
+	enum LogEntryType : u8
+	{
+		RV_LOG_ENTRY_FORMAT,
+		RV_LOG_ENTRY_RECORD,
+	};
+
+	class BinaryLogWriter
+	{
+	public:
+		BinaryLogWriter() = default;
+		BinaryLogWriter(const BinaryLogWriter&) = delete;
+		~BinaryLogWriter();
+
+		BinaryLogWriter& operator= (const BinaryLogWriter&) = delete;
+
+		bool Open(const char* filename);
+		void Close();
+		bool IsOpen() const;
+
+		void Write(const LogRecord& record);
+		void Flush();
+
+	private:
+		std::FILE* file = nullptr;
+		std::unordered_set<u32> formats;
+	};
+
+	class BinaryLogReader
+	{
+	public:
+		BinaryLogReader() = default;
+		BinaryLogReader(const BinaryLogReader&) = delete;
+		~BinaryLogReader();
+
+		BinaryLogReader& operator= (const BinaryLogReader&) = delete;
+
+		bool Open(const char* filename);
+		void Close();
+
+		// Skips format entries, record.format points into the reader and stays valid until it is closed
+		bool Next(LogRecord& record);
+
+		const LogFileHeader& Header() const;
+
+	private:
+		std::FILE* file = nullptr;
+		LogFileHeader header;
+		std::unordered_map<u32, std::string> formats;
+	};
+}
@@ -3,10 +3,17 @@
 #include "Engine/Utility/Result.h"
 #include "Engine/Utility/Flags.h"
 #include "Engine/Utility/UnknownObject.h"
-#include <deque>
+#include "Engine/Utility/RingBuffer.h"
+#include "Engine/Core/LogRecord.h"
+#include <vector>
 #include <chrono>
 #include <ios>
 #include <mutex>
+#include <thread>
+#include <atomic>
+#include <span>
+#include <variant>
+#include <cstdio>
 
 namespace rv
 {
@@ -23,24 +30,126 @@ namespace rv
 		std::string message;
 	};
 
+	/*
+		Keeps the most recent messages, bounded by a message count and by an approximate byte budget.
+		The oldest messages are evicted first.
+	*/
+	class MessageHistory
+	{
+	public:
+		static constexpr size_t default_capacity = 4096;
+		static constexpr size_t default_byte_budget = 4 * 1024 * 1024;
+
+		MessageHistory(size_t capacity = default_capacity, size_t byteBudget = default_byte_budget);
+
+		void push(Message&& message);
+		void clear();
+		void resize(size_t capacity, size_t byteBudget);
+
+		size_t size() const { return count; }
+		bool empty() const { return count == 0; }
+		size_t bytes() const { return used; }
+		size_t evicted() const { return evictedCount; }
+		size_t capacity() const { return ring.size(); }
+		size_t byte_budget() const { return byteBudget; }
+
+		// 0 is the oldest message
+		const Message& operator[] (size_t index) const { return ring[(first + index) % ring.size()]; }
+
+		template<typename F>
+		void for_each(F&& function) const
+		{
+			for (size_t i = 0; i < count; ++i)
+				function((*this)[i]);
+		}
+
+	private:
+		static size_t cost(const Message& message) { return sizeof(Message) + message.message.capacity(); }
+		void pop();
+
+		std::vector<Message> ring;
+		size_t first = 0;
+		size_t count = 0;
+		size_t used = 0;
+		size_t byteBudget;
+		size_t evictedCount = 0;
+	};
+
+	/*
+		In async mode Log only pushes the message into a lock-free ring,
+		a background thread formats and writes the messages in batches.
+	*/
 	class Logger
 	{
 	public:
+		static constexpr size_t default_async_capacity = 4096;
+		static constexpr size_t async_batch_size = 256;
+
 		Logger(Flags<Severity> allowedSeverity = combine(RV_SEVERITY_INFO, RV_SEVERITY_WARNING, RV_SEVERITY_ERROR));
-		virtual ~Logger() = default;
+		virtual ~Logger();
 
 		void Log(const Message& message);
+		void Log(Message&& message);
 		void Log(const std::string& message, Severity severity = RV_SEVERITY_INFO);
 		void Log(std::string&& message, Severity severity = RV_SEVERITY_INFO);
+		void Log(const LogRecord& record);
+
+		// Only captures the raw arguments, formatting happens when the record is written
+		template<typename... Args>
+		void LogFormatted(Severity severity, LogFormat<Args...> format, const Args&... args)
+		{
+			if (!allowedSeverity.contain(severity))
+				return;
+			LogRecord record;
+			LogRecord::Encode(record, severity, format, args...);
+			Log(record);
+		}
+
+		void StartAsync(size_t capacity = default_async_capacity);
+		void StopAsync();
+		bool Async() const;
+
+		// Blocks until every message logged so far has been written
+		void Flush();
+
+		void SetHistoryLimits(size_t capacity, size_t byteBudget);
 
 		Flags<Severity> allowedSeverity;
 
 	protected:
 		virtual void OnLog(const Message& message) {}
+		virtual void OnLogBatch(std::span<const Message> messages);
+		virtual void OnLogRecord(const LogRecord& record) {}
+		virtual void OnFlush() {}
+
+		Message ToMessage(const LogRecord& record) const;
+
+	private:
+		// Messages and records share one ring, so they are written in the order they were logged
+		typedef std::variant<LogRecord, Message> Entry;
+
+		// Returns false without pushing once StopAsync has cleared running
+		template<typename T>
+		bool Push(T&& value);
+		void Handle(std::vector<Entry>& entries, std::vector<Message>& batch);
+		void Wake();
+		void Worker();
 
 	protected:
-		std::deque<Message> messages;
+		MessageHistory messages;
 		std::mutex mutex;
+
+	private:
+		RingBuffer<Entry> queue;
+		LogFileHeader clock = LogFileHeader::Now();
+		std::thread worker;
+		std::atomic<bool> running = false;
+		// Producers between their check of running and the end of their push
+		std::atomic<u32> producers = 0;
+		std::atomic<bool> waiting = false;
+		std::atomic<u32> signal = 0;
+		std::atomic<u64> queued = 0;
+		std::atomic<u64> handled = 0;
 	};
 }
 
@@ -60,19 +169,36 @@ namespace rv
 	class DebugLogger : public Logger
 	{
 	public:
-		DebugLogger(Flags<Severity> allowedSeverity = combine(RV_SEVERITY_INFO, RV_SEVERITY_WARNING, RV_SEVERITY_ERROR), const char* dumpFile = "Application/log.txt");
+		DebugLogger(Flags<Severity> allowedSeverity = combine(RV_SEVERITY_INFO, RV_SEVERITY_WARNING, RV_SEVERITY_ERROR), const char* dumpFile = "Application/log.txt", const char* binaryFile = "Application/log.bin", bool async = true);
 		~DebugLogger();
 
 		const char* dumpFile;
+		const char* binaryFile;
+
+		static constexpr size_t sync_bytes = 64 * 1024;
+		static constexpr std::chrono::seconds sync_interval = std::chrono::seconds(1);
 
 	protected:
 		void OnLog(const Message& message) override;
+		void OnLogBatch(std::span<const Message> messages) override;
+		void OnLogRecord(const LogRecord& record) override;
+		void OnFlush() override;
+
+	private:
+		// The dump file is streamed as messages arrive and synced to disk periodically
+		void Write(const std::string& text);
+		void Sync();
+
+		std::FILE* dump = nullptr;
+		BinaryLogWriter binary;
+		size_t unsynced = 0;
+		std::chrono::steady_clock::time_point lastSync;
 	};
 #else
 	class DebugLogger
 	{
 	public:
-		DebugLogger(Flags<Severity> allowedSeverity = combine(RV_SEVERITY_INFO, RV_SEVERITY_WARNING, RV_SEVERITY_ERROR), const char* dumpFile = "Application/log.txt");
+		DebugLogger(Flags<Severity> allowedSeverity = combine(RV_SEVERITY_INFO, RV_SEVERITY_WARNING, RV_SEVERITY_ERROR), const char* dumpFile = "Application/log.txt", const char* binaryFile = "Application/log.bin", bool async = true);
 
 		void Log(const Message& message);
 		void Log(const std::string& message, Severity severity = RV_SEVERITY_INFO);
@@ -80,6 +206,7 @@ namespace rv
 
 		Flags<Severity> allowedSeverity;
 		const char* dumpFile;
+		const char* binaryFile;
 	};
 #endif
 
@@ -88,8 +215,14 @@ namespace rv
 
 #ifdef RV_DEBUG_LOGGER
 #define rv_log(msg)					rv::debug.Log(msg)
+#define rv_logf(...)				(rv::debug.allowedSeverity.contain(rv::RV_SEVERITY_INFO)	? rv::debug.LogFormatted(rv::RV_SEVERITY_INFO, __VA_ARGS__)		: void())
+#define rv_logf_warning(...)		(rv::debug.allowedSeverity.contain(rv::RV_SEVERITY_WARNING)	? rv::debug.LogFormatted(rv::RV_SEVERITY_WARNING, __VA_ARGS__)	: void())
+#define rv_logf_error(...)			(rv::debug.allowedSeverity.contain(rv::RV_SEVERITY_ERROR)	? rv::debug.LogFormatted(rv::RV_SEVERITY_ERROR, __VA_ARGS__)	: void())
 #define rv_debug_logger_only(code)	code
 #else
-#define rv_log(msg)
+#define rv_log(msg)					((void)0)
+#define rv_logf(...)				((void)0)
+#define rv_logf_warning(...)		((void)0)
+#define rv_logf_error(...)			((void)0)
 #define rv_debug_logger_only(code)
 #endif
\ No newline at end of file
@@ -35,6 +35,8 @@ namespace rv
 			EventData(type_id), size(size), minimized(minimized), maximized(maximized)
 		{}
 
+		static void Coalesce(WindowResizedEvent& pending, const WindowResizedEvent& event) { pending = event; }
+
 		Extent2D size;
 		bool minimized;
 		bool maximized;
@@ -89,7 +91,7 @@ namespace rv
 		class Window : public EventQueue
 		{
 		public:
-			Window() = default;
+			Window();
 			~Window();
 
 			static Result Create(Window& window, const std::string& title, uint width, uint height, bool resize = false);
@@ -1,4 +1,6 @@
 #include "Engine/Core/Application.h"
+#include "Engine/Utility/PerformanceLogger.h"
+#include "Engine/Core/CompileTimeInfo.h"
 
 rv::Application::Application()
 	:
@@ -29,11 +31,16 @@ void rv::Application::Run()
 	Timer timer;
 	while (renderer.window.HandleMessages())
 	{
-		input.HandleInput();
-		Update(timer.Mark());
-		if (renderer.window.Closed())
-			break;
-		renderer.Render().expect("Render Failed");
+		{
+			rv_performance_scope("Application::Run");
+			input.HandleInput();
+			Update(timer.Mark());
+			if (renderer.window.Closed())
+				break;
+			renderer.Render().expect("Render Failed");
+		}
+		rv_performance_only(performance.EndFrame());
 	}
 	renderer.Wait().expect();
+	rv_debug_only(rv_performance_only(performance.ExportChromeTrace("Application/trace.json")));
 }
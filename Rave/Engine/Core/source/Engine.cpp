@@ -17,9 +17,14 @@ rv::Result rv::Engine::Create(Engine& engine, const GraphicsInfo& info)
 	rv_result;
 	rv_debug_logger_only(Timer timer);
 
-	rv_rif(Graphics::Create(engine.graphics, info));
+	rv_rif(JobSystem::Create(engine.jobs));
+	rv_rif(Graphics::Create(engine.graphics, info, &engine.jobs));
 	rv_rif(engine.graphics.AddShaderPath("../Engine/Graphics/Shaders/"));
 
+	// The built-in drawables need these, missing ones are still reported when a drawable asks for them
+	if (engine.graphics.LoadShaders({ "triangle.vert", "triangle.frag", "instanced.vert", "instanced.frag" }).failed())
+		rv_logf_warning("Unable to preload the built-in shaders");
+
 	rv_log(str("Created Engine in ", timer.Mark().seconds(), "s"));
 	return result;
 }
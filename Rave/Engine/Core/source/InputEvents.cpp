@@ -62,6 +62,12 @@ rv::MouseMovedEvent::MouseMovedEvent(const Point& position, Flags<MouseButton> p
 {
 }
 
+void rv::MouseMovedEvent::Coalesce(MouseMovedEvent& pending, const MouseMovedEvent& event)
+{
+	pending.position = event.position;
+	pending.pressedButtons |= event.pressedButtons;
+}
+
 rv::MouseButtonPressedEvent::MouseButtonPressedEvent()
 	:
 	EventData(type_id),
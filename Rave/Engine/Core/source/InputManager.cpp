@@ -1,5 +1,6 @@
 #include "Engine/Core/InputManager.h"
 #include "Engine/Utility/Error.h"
+#include "Engine/Utility/PerformanceLogger.h"
 #include "Engine/Utility/String.h"
 #include <stdarg.h>
 
@@ -11,14 +12,15 @@ rv::InputManager::InputManager(Window& window)
 
 void rv::InputManager::HandleInput()
 {
+	rv_performance_scope("InputManager::HandleInput");
 	bool posChanged = false;
-	while (Event e = listener.GetEvent())
+	listener.DrainEvents([&](const Event& e)
 	{
 		switch (e.ID())
 		{
 			case window_resized_event:
 			{
-				auto& event = e.get<WindowResizedEvent>();
+				const auto& event = e.get<WindowResizedEvent>();
 				if (!event.minimized)
 				{
 					size = event.size;
@@ -29,7 +31,7 @@ void rv::InputManager::HandleInput()
 
 			case key_pressed_event:
 			{
-				auto& event = e.get<KeyPressedEvent>();
+				const auto& event = e.get<KeyPressedEvent>();
 				if (!event.repeated)
 				{
 					keyboard.keys[event.key] = true;
@@ -40,7 +42,7 @@ void rv::InputManager::HandleInput()
 
 			case key_released_event:
 			{
-				auto& event = e.get<KeyPressedEvent>();
+				const auto& event = e.get<KeyReleasedEvent>();
 				keyboard.keys[event.key] = false;
 			}
 			break;
@@ -53,7 +55,7 @@ void rv::InputManager::HandleInput()
 
 			case mouse_moved_event:
 			{
-				auto& event = e.get<MouseMovedEvent>();
+				const auto& event = e.get<MouseMovedEvent>();
 				mouse.screenPosition = event.position;
 				posChanged = true;
 			}
@@ -61,7 +63,7 @@ void rv::InputManager::HandleInput()
 
 			case mbutton_pressed_event:
 			{
-				auto& event = e.get<MouseButtonPressedEvent>();
+				const auto& event = e.get<MouseButtonPressedEvent>();
 				auto& button = mouse.GetButton(event.button);
 				button.pressed = true;
 				++button.flagged;
@@ -70,13 +72,13 @@ void rv::InputManager::HandleInput()
 
 			case mbutton_released_event:
 			{
-				auto& event = e.get<MouseButtonPressedEvent>();
+				const auto& event = e.get<MouseButtonReleasedEvent>();
 				auto& button = mouse.GetButton(event.button);
 				button.pressed = false;
 			};
 			break;
 		}
-	}
+	});
 
 	if (posChanged)
 	{
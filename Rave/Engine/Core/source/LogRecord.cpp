@@ -0,0 +1,278 @@
+#include "Engine/Core/LogRecord.h"
+#include <sstream>
+#include <iomanip>
+#include <ctime>
+#include <algorithm>
+
+void rv::LogRecord::AppendString(std::string_view string)
+{
+	if (size + 1 + sizeof(u16) > max_data)
+		return;
+	const u16 length = (u16)std::min<size_t>(string.size(), max_data - size - 1 - sizeof(u16));
+	data[size++] = RV_LOG_ARG_STRING;
+	std::memcpy(data + size, &length, sizeof(u16));
+	size += sizeof(u16);
+	std::memcpy(data + size, string.data(), length);
+	size += length;
+	++argumentCount;
+}
+
+template<typename T>
+static bool read_argument(const rv::u8* data, size_t size, size_t& offset, T& value)
+{
+	if (offset + sizeof(T) > size)
+		return false;
+	std::memcpy(&value, data + offset, sizeof(T));
+	offset += sizeof(T);
+	return true;
+}
+
+template<typename T, typename O>
+static bool write_argument(const rv::u8* data, size_t size, size_t& offset, O&& write)
+{
+	T value;
+	if (!read_argument(data, size, offset, value))
+		return false;
+	write(value);
+	return true;
+}
+
+std::string rv::LogRecord::Format() const
+{
+	std::ostringstream ss;
+	// Records read back from a file aren't trusted, a truncated or corrupt argument stops the substitution
+	const size_t end = std::min<size_t>(size, max_data);
+	size_t offset = 0;
+	u8 argument = 0;
+	bool valid = true;
+	for (const char* c = format; c && *c; ++c)
+	{
+		if (!valid || c[0] != '{' || c[1] != '}' || argument == argumentCount || offset >= end)
+		{
+			ss << *c;
+			continue;
+		}
+
+		const LogArgumentType type = (LogArgumentType)data[offset++];
+		switch (type)
+		{
+			case RV_LOG_ARG_INT:		valid = write_argument<i64>(data, end, offset, [&](i64 v) { ss << v; }); break;
+			case RV_LOG_ARG_UINT:		valid = write_argument<u64>(data, end, offset, [&](u64 v) { ss << v; }); break;
+			case RV_LOG_ARG_FLOAT:		valid = write_argument<double>(data, end, offset, [&](double v) { ss << v; }); break;
+			case RV_LOG_ARG_BOOL:		valid = write_argument<u8>(data, end, offset, [&](u8 v) { ss << (v ? "true" : "false"); }); break;
+			case RV_LOG_ARG_CHAR:		valid = write_argument<char>(data, end, offset, [&](char v) { ss << v; }); break;
+			case RV_LOG_ARG_POINTER:	valid = write_argument<u64>(data, end, offset, [&](u64 v) { ss << (const void*)(uintptr_t)v; }); break;
+			case RV_LOG_ARG_STRING:
+			{
+				u16 length = 0;
+				valid = read_argument(data, end, offset, length) && offset + length <= end;
+				if (valid)
+				{
+					ss.write((const char*)data + offset, length);
+					offset += length;
+				}
+			}
+			break;
+			default:
+				valid = false;
+				break;
+		}
+
+		if (!valid)
+		{
+			ss << *c;
+			continue;
+		}
+		++c;
+		++argument;
+	}
+	return ss.str();
+}
+
+std::string rv::FormatLogMessage(Severity severity, std::chrono::system_clock::time_point time, const std::string& message, const char* date_fmt)
+{
+	std::ostringstream ss;
+	switch (severity)
+	{
+		case RV_SEVERITY_INFO:		ss << "[Info]     "; break;
+		case RV_SEVERITY_WARNING:	ss << "[Warning]  "; break;
+		case RV_SEVERITY_ERROR:		ss << "[Error]    "; break;
+	}
+
+	time_t t = std::chrono::system_clock::to_time_t(time);
+	tm tm{};
+#ifdef RV_PLATFORM_WINDOWS
+	localtime_s(&tm, &t);
+#else
+	localtime_r(&t, &tm);
+#endif
+	ss << std::put_time(&tm, date_fmt) << "    " << message;
+	return ss.str();
+}
+
+rv::LogFileHeader rv::LogFileHeader::Now()
+{
+	LogFileHeader header;
+	header.anchorTicks = std::chrono::steady_clock::now().time_since_epoch().count();
+	header.anchorSystem = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+	return header;
+}
+
+std::chrono::system_clock::time_point rv::LogFileHeader::Time(u64 ticks) const
+{
+	const long double elapsed = (long double)((i64)ticks - anchorTicks) * periodNum / periodDen;
+	const std::chrono::nanoseconds system(anchorSystem + (i64)(elapsed * 1e9L));
+	return std::chrono::system_clock::time_point(std::chrono::duration_cast<std::chrono::system_clock::duration>(system));
+}
+
+rv::BinaryLogWriter::~BinaryLogWriter()
+{
+	Close();
+}
+
+bool rv::BinaryLogWriter::Open(const char* filename)
+{
+	Close();
+#ifdef RV_PLATFORM_WINDOWS
+	if (fopen_s(&file, filename, "wb"))
+		file = nullptr;
+#else
+	file = std::fopen(filename, "wb");
+#endif
+	if (!file)
+		return false;
+
+	const LogFileHeader header = LogFileHeader::Now();
+	std::fwrite(&header, sizeof(header), 1, file);
+	return true;
+}
+
+void rv::BinaryLogWriter::Close()
+{
+	if (file)
+	{
+		std::fclose(file);
+		file = nullptr;
+	}
+	formats.clear();
+}
+
+bool rv::BinaryLogWriter::IsOpen() const
+{
+	return file;
+}
+
+void rv::BinaryLogWriter::Write(const LogRecord& record)
+{
+	if (!file)
+		return;
+
+	if (formats.insert(record.id).second)
+	{
+		const u8 type = RV_LOG_ENTRY_FORMAT;
+		const u16 length = (u16)std::min<size_t>(std::strlen(record.format), 0xFFFF);
+		std::fwrite(&type, sizeof(type), 1, file);
+		std::fwrite(&record.id, sizeof(record.id), 1, file);
+		std::fwrite(&length, sizeof(length), 1, file);
+		std::fwrite(record.format, 1, length, file);
+	}
+
+	const u8 type = RV_LOG_ENTRY_RECORD;
+	const u8 severity = record.severity;
+	std::fwrite(&type, sizeof(type), 1, file);
+	std::fwrite(&record.id, sizeof(record.id), 1, file);
+	std::fwrite(&severity, sizeof(severity), 1, file);
+	std::fwrite(&record.argumentCount, sizeof(record.argumentCount), 1, file);
+	std::fwrite(&record.size, sizeof(record.size), 1, file);
+	std::fwrite(&record.ticks, sizeof(record.ticks), 1, file);
+	std::fwrite(record.data, 1, record.size, file);
+}
+
+void rv::BinaryLogWriter::Flush()
+{
+	if (file)
+		std::fflush(file);
+}
+
+rv::BinaryLogReader::~BinaryLogReader()
+{
+	Close();
+}
+
+bool rv::BinaryLogReader::Open(const char* filename)
+{
+	Close();
+#ifdef RV_PLATFORM_WINDOWS
+	if (fopen_s(&file, filename, "rb"))
+		file = nullptr;
+#else
+	file = std::fopen(filename, "rb");
+#endif
+	if (!file)
+		return false;
+
+	const LogFileHeader expected;
+	if (std::fread(&header, sizeof(header), 1, file) != 1 || std::memcmp(header.magic, expected.magic, sizeof(header.magic)) || header.version != expected.version)
+	{
+		Close();
+		return false;
+	}
+	return true;
+}
+
+void rv::BinaryLogReader::Close()
+{
+	if (file)
+	{
+		std::fclose(file);
+		file = nullptr;
+	}
+	formats.clear();
+}
+
+bool rv::BinaryLogReader::Next(LogRecord& record)
+{
+	if (!file)
+		return false;
+
+	u8 type;
+	while (std::fread(&type, sizeof(type), 1, file) == 1)
+	{
+		u32 id;
+		if (std::fread(&id, sizeof(id), 1, file) != 1)
+			return false;
+
+		if (type == RV_LOG_ENTRY_FORMAT)
+		{
+			u16 length;
+			if (std::fread(&length, sizeof(length), 1, file) != 1)
+				return false;
+			std::string text(length, '\0');
+			if (std::fread(text.data(), 1, length, file) != length)
+				return false;
+			formats[id] = std::move(text);
+			continue;
+		}
+
+		u8 severity;
+		if (std::fread(&severity, sizeof(severity), 1, file) != 1 ||
+			std::fread(&record.argumentCount, sizeof(record.argumentCount), 1, file) != 1 ||
+			std::fread(&record.size, sizeof(record.size), 1, file) != 1 ||
+			std::fread(&record.ticks, sizeof(record.ticks), 1, file) != 1 ||
+			record.size > LogRecord::max_data ||
+			std::fread(record.data, 1, record.size, file) != record.size)
+			return false;
+
+		auto format = formats.find(id);
+		record.id = id;
+		record.severity = (Severity)severity;
+		record.format = format == formats.end() ? "" : format->second.c_str();
+		return true;
+	}
+	return false;
+}
+
+const rv::LogFileHeader& rv::BinaryLogReader::Header() const
+{
+	return header;
+}
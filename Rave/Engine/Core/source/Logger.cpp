@@ -1,9 +1,15 @@
 #include "Engine/Core/Logger.h"
 #include <iomanip>
+#include <vector>
+#include <exception>
 #ifdef RV_DEBUG_LOGGER
 #include <iostream>
-#include <fstream>
 #include "Engine/Core/SystemInclude.h"
+#ifdef RV_PLATFORM_WINDOWS
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
 #endif
 
 rv::DebugLogger rv::debug;
@@ -33,19 +39,60 @@ rv::Message::Message(std::string&& message, Severity severity)
 
 std::string rv::Message::format(const char* date_fmt) const
 {
-	std::ostringstream ss;
-	switch (severity)
-	{
-		case RV_SEVERITY_INFO:		ss << "[Info]     "; break;
-		case RV_SEVERITY_WARNING:	ss << "[Warning]  "; break;
-		case RV_SEVERITY_ERROR:		ss << "[Error]    "; break;
-	}
+	return FormatLogMessage(severity, time, message, date_fmt);
+}
+
+rv::MessageHistory::MessageHistory(size_t capacity, size_t byteBudget)
+	:
+	ring(capacity ? capacity : 1),
+	byteBudget(byteBudget)
+{
+}
+
+void rv::MessageHistory::push(Message&& message)
+{
+	const size_t size = cost(message);
+	while (count && (count == ring.size() || used + size > byteBudget))
+		pop();
+
+	ring[(first + count) % ring.size()] = std::move(message);
+	used += size;
+	++count;
+}
+
+void rv::MessageHistory::pop()
+{
+	Message& message = ring[first];
+	used -= cost(message);
+	message = Message();
+	first = (first + 1) % ring.size();
+	--count;
+	++evictedCount;
+}
 
-	time_t t = std::chrono::system_clock::to_time_t(time);
-	tm tm{};
-	errno_t e = localtime_s(&tm, &t);
-	ss << std::put_time(&tm, date_fmt) << "    " << message;
-	return ss.str();
+void rv::MessageHistory::clear()
+{
+	while (count)
+		pop();
+	first = 0;
+	evictedCount = 0;
+}
+
+void rv::MessageHistory::resize(size_t capacity, size_t byteBudget)
+{
+	std::vector<Message> old;
+	old.reserve(count);
+	for (size_t i = 0; i < count; ++i)
+		old.push_back(std::move(ring[(first + i) % ring.size()]));
+
+	ring.clear();
+	ring.resize(capacity ? capacity : 1);
+	this->byteBudget = byteBudget;
+	first = 0;
+	count = 0;
+	used = 0;
+	for (auto& message : old)
+		push(std::move(message));
 }
 
 rv::Logger::Logger(Flags<Severity> allowedSeverity)
@@ -54,14 +101,57 @@ rv::Logger::Logger(Flags<Severity> allowedSeverity)
 {
 }
 
-void rv::Logger::Log(const Message& message)
+rv::Logger::~Logger()
 {
-	if (allowedSeverity.contain(message.severity))
+	StopAsync();
+}
+
+template<typename T>
+bool rv::Logger::Push(T&& value)
+{
+	if (!running.load(std::memory_order_relaxed))
+		return false;
+
+	// Pairs with StopAsync: either it sees this producer, or the producer sees running cleared and writes synchronously.
+	// The entry is only built afterwards, so a refused message is still intact for the caller.
+	producers.fetch_add(1, std::memory_order_seq_cst);
+	if (!running.load(std::memory_order_seq_cst))
 	{
-		std::lock_guard guard(mutex);
-		messages.push_back(message);
-		OnLog(message);
+		producers.fetch_sub(1, std::memory_order_release);
+		return false;
+	}
+
+	queued.fetch_add(1, std::memory_order_relaxed);
+	Entry entry(std::forward<T>(value));
+	while (!queue.push(std::move(entry)))
+	{
+		Wake();
+		std::this_thread::yield();
 	}
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (waiting.load(std::memory_order_relaxed))
+		Wake();
+	producers.fetch_sub(1, std::memory_order_release);
+	return true;
+}
+
+void rv::Logger::Log(const Message& message)
+{
+	if (allowedSeverity.contain(message.severity))
+		Log(Message(message));
+}
+
+void rv::Logger::Log(Message&& message)
+{
+	if (!allowedSeverity.contain(message.severity))
+		return;
+
+	if (Push(std::move(message)))
+		return;
+
+	std::lock_guard guard(mutex);
+	OnLog(message);
+	messages.push(std::move(message));
 }
 
 void rv::Logger::Log(const std::string& message, Severity severity)
@@ -74,23 +164,199 @@ void rv::Logger::Log(std::string&& message, Severity severity)
 	Log(Message(std::move(message), severity));
 }
 
+void rv::Logger::Log(const LogRecord& record)
+{
+	if (!allowedSeverity.contain(record.severity))
+		return;
+
+	if (Push(record))
+		return;
+
+	Message message = ToMessage(record);
+	std::lock_guard guard(mutex);
+	OnLogRecord(record);
+	OnLog(message);
+	messages.push(std::move(message));
+}
+
+rv::Message rv::Logger::ToMessage(const LogRecord& record) const
+{
+	Message message(record.Format(), record.severity);
+	message.time = clock.Time(record.ticks);
+	return message;
+}
+
+void rv::Logger::StartAsync(size_t capacity)
+{
+	if (running.load())
+		return;
+	queue.Reserve(capacity);
+	running.store(true);
+	worker = std::thread(&Logger::Worker, this);
+}
+
+void rv::Logger::StopAsync()
+{
+	if (!worker.joinable())
+		return;
+	running.store(false);
+	Wake();
+	worker.join();
+
+	// Messages that raced with the stop are written on this thread.
+	// Producers that saw running set may still be pushing, so keep draining (a full ring would block them) until none are left.
+	std::vector<Entry> entries;
+	std::vector<Message> batch;
+	Entry entry;
+	while (true)
+	{
+		const bool idle = producers.load(std::memory_order_acquire) == 0;
+		while (queue.pop(entry))
+			entries.push_back(std::move(entry));
+		Handle(entries, batch);
+		entries.clear();
+		batch.clear();
+		if (idle)
+			break;
+		std::this_thread::yield();
+	}
+}
+
+bool rv::Logger::Async() const
+{
+	return running.load(std::memory_order_relaxed);
+}
+
+void rv::Logger::Flush()
+{
+	if (worker.joinable() && std::this_thread::get_id() != worker.get_id())
+	{
+		const u64 target = queued.load();
+		Wake();
+		for (u64 current = handled.load(); current < target; current = handled.load())
+			handled.wait(current);
+	}
+	std::lock_guard guard(mutex);
+	OnFlush();
+}
+
+void rv::Logger::SetHistoryLimits(size_t capacity, size_t byteBudget)
+{
+	std::lock_guard guard(mutex);
+	messages.resize(capacity, byteBudget);
+}
+
+void rv::Logger::OnLogBatch(std::span<const Message> messages)
+{
+	for (const auto& message : messages)
+		OnLog(message);
+}
+
+void rv::Logger::Handle(std::vector<Entry>& entries, std::vector<Message>& batch)
+{
+	const size_t count = entries.size();
+	if (count == 0)
+		return;
+
+	// Formatted outside the lock, the batch keeps the order of the entries
+	for (auto& entry : entries)
+	{
+		if (const LogRecord* record = std::get_if<LogRecord>(&entry))
+			batch.push_back(ToMessage(*record));
+		else
+			batch.push_back(std::move(std::get<Message>(entry)));
+	}
+	{
+		std::lock_guard guard(mutex);
+		for (const auto& entry : entries)
+			if (const LogRecord* record = std::get_if<LogRecord>(&entry))
+				OnLogRecord(*record);
+		OnLogBatch(batch);
+		for (auto& message : batch)
+			messages.push(std::move(message));
+	}
+	handled.fetch_add(count, std::memory_order_release);
+	handled.notify_all();
+}
+
+void rv::Logger::Wake()
+{
+	signal.fetch_add(1, std::memory_order_seq_cst);
+	signal.notify_one();
+}
+
+void rv::Logger::Worker()
+{
+	std::vector<Entry> entries;
+	std::vector<Message> batch;
+	entries.reserve(async_batch_size);
+	batch.reserve(async_batch_size);
+	Entry entry;
+	while (true)
+	{
+		while (entries.size() < async_batch_size && queue.pop(entry))
+			entries.push_back(std::move(entry));
+
+		if (!entries.empty())
+		{
+			Handle(entries, batch);
+			entries.clear();
+			batch.clear();
+			continue;
+		}
+
+		if (!running.load())
+			break;
+
+		waiting.store(true, std::memory_order_seq_cst);
+		const u32 current = signal.load(std::memory_order_seq_cst);
+		if (queue.empty() && running.load())
+			signal.wait(current);
+		waiting.store(false, std::memory_order_relaxed);
+	}
+}
+
 #ifdef RV_DEBUG_LOGGER
 
-rv::DebugLogger::DebugLogger(Flags<Severity> allowedSeverity, const char* dumpFile)
+static std::terminate_handler previous_terminate = nullptr;
+
+rv::DebugLogger::DebugLogger(Flags<Severity> allowedSeverity, const char* dumpFile, const char* binaryFile, bool async)
 	:
 	Logger(allowedSeverity),
-	dumpFile(dumpFile)
+	dumpFile(dumpFile),
+	binaryFile(binaryFile),
+	lastSync(std::chrono::steady_clock::now())
 {
+	if (dumpFile)
+	{
+#ifdef RV_PLATFORM_WINDOWS
+		if (fopen_s(&dump, dumpFile, "w"))
+			dump = nullptr;
+#else
+		dump = std::fopen(dumpFile, "w");
+#endif
+	}
+	if (binaryFile)
+		binary.Open(binaryFile);
+
+	if (async)
+		StartAsync();
+
+	previous_terminate = std::set_terminate([]() {
+		rv::debug.Flush();
+		if (previous_terminate)
+			previous_terminate();
+		std::abort();
+	});
 }
 
 rv::DebugLogger::~DebugLogger()
 {
-	if (dumpFile)
+	StopAsync();
+	if (dump)
 	{
-		std::ofstream file(dumpFile);
-		if (file.is_open())
-			for (const auto& m : messages)
-				file << m.format() << '\n';
+		Sync();
+		std::fclose(dump);
 	}
 }
 
@@ -101,14 +367,66 @@ void rv::DebugLogger::OnLog(const Message& message)
 	std::cout << fmt;
 	if constexpr (cti.platform.windows)
 		OutputDebugString(fmt.c_str());
+	Write(fmt);
+}
+
+void rv::DebugLogger::OnLogBatch(std::span<const Message> messages)
+{
+	std::string fmt;
+	for (const auto& message : messages)
+	{
+		fmt += message.format();
+		fmt.push_back('\n');
+	}
+	std::cout << fmt;
+	if constexpr (cti.platform.windows)
+		OutputDebugString(fmt.c_str());
+	Write(fmt);
+}
+
+void rv::DebugLogger::OnLogRecord(const LogRecord& record)
+{
+	binary.Write(record);
+}
+
+void rv::DebugLogger::OnFlush()
+{
+	std::cout.flush();
+	Sync();
+}
+
+void rv::DebugLogger::Write(const std::string& text)
+{
+	if (!dump)
+		return;
+	std::fwrite(text.data(), 1, text.size(), dump);
+	unsynced += text.size();
+	if (unsynced >= sync_bytes || std::chrono::steady_clock::now() - lastSync >= sync_interval)
+		Sync();
+}
+
+void rv::DebugLogger::Sync()
+{
+	binary.Flush();
+	if (!dump)
+		return;
+	std::fflush(dump);
+#ifdef RV_PLATFORM_WINDOWS
+	_commit(_fileno(dump));
+#else
+	fsync(fileno(dump));
+#endif
+	unsynced = 0;
+	lastSync = std::chrono::steady_clock::now();
 }
 
 #else
 
-rv::DebugLogger::DebugLogger(Flags<Severity> allowedSeverity, const char* dumpFile)
+rv::DebugLogger::DebugLogger(Flags<Severity> allowedSeverity, const char* dumpFile, const char* binaryFile, bool async)
 	:
 	allowedSeverity(allowedSeverity),
-	dumpFile(dumpFile)
+	dumpFile(dumpFile),
+	binaryFile(binaryFile)
 {
 }
 
@@ -3,6 +3,7 @@
 #include "Engine/Utility/Exception.h"
 #include "Engine/Core/SystemInclude.h"
 #include "Engine/Graphics/DebugMessenger.h"
+#include "Engine/Core/Logger.h"
 
 void message_box(const char* title, const char* text, rv::Severity severity)
 {
@@ -36,6 +37,7 @@ int main()
 		result = rave_main();
 		if (result.failed())
 		{
+			rv_debug_logger_only(rv::debug.Flush());
 			message_box("rv::ResultException", result.exception("Application failed: 'rave_main()' returned fatal result").what(), result.severity());
 		}
 		else
@@ -50,14 +52,17 @@ int main()
 	}
 	catch (const rv::ResultException& e)
 	{
+		rv_debug_logger_only(rv::debug.Flush());
 		message_box("rv::ResultException", e.what(), e.result().severity());
 	}
 	catch (const std::exception& e)
 	{
+		rv_debug_logger_only(rv::debug.Flush());
 		message_box("std::exception", e.what(), rv::RV_SEVERITY_ERROR);
 	}
 	catch (...)
 	{
+		rv_debug_logger_only(rv::debug.Flush());
 		message_box("Unknown exception", "Something went wrong, please contact the developper(s)", rv::RV_SEVERITY_ERROR);
 	}
 	return result.fatal() ? EXIT_FAILURE : EXIT_SUCCESS;
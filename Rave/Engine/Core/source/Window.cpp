@@ -26,6 +26,12 @@ rv::Result rv::win32::WindowClass::Create(WindowClass& window, const std::string
 }
 
 
+rv::win32::Window::Window()
+{
+	EnableCoalescing<MouseMovedEvent>();
+	EnableCoalescing<WindowResizedEvent>();
+}
+
 rv::win32::Window::~Window()
 {
 	SetWindowLongPtr(hwnd, GWLP_USERDATA, NULL);
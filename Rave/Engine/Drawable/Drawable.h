@@ -29,16 +29,26 @@ namespace rv
 	class Renderer;
 	struct DrawableRecorder;
 
-	typedef void (*DrawableRecordFunction)(CommandBuffer&, Graphics&, Renderer&, const DrawableRecorder&, u32);
+	// Part of a recorder's work, in the units returned by its count function
+	struct DrawableRange
+	{
+		u32 first = 0;
+		u32 count = 0;
+	};
+
+	typedef void (*DrawableRecordFunction)(CommandBuffer&, Graphics&, Renderer&, const DrawableRecorder&, u32, DrawableRange);
+	typedef void (*DrawableUpdateFunction)(Graphics&, Renderer&, u32);
+	typedef u32 (*DrawableCountFunction)(Graphics&);
 
 	struct DrawableRecorder
 	{
 		DrawableRecorder() = default;
 
 		DrawableRecordFunction recordFunction = nullptr;
+		DrawableUpdateFunction updateFunction = nullptr;	// called every frame before the image is drawn
+		DrawableCountFunction countFunction = nullptr;		// work units the recording can be split into, without it the whole type is one range
 		Drawable drawable;
 		FullPipeline* pipeline = nullptr;
-		u32 commandIndex = 0;
 	};
 
 	class Engine;
@@ -51,6 +61,7 @@ namespace rv
 		RV_DRAWABLE_DATA,
 		RV_DRAWABLE_RENDERER_DATA,
 		RV_DRAWABLE_IMAGE_DATA,
+		RV_DRAWABLE_STATIC_IMAGE_DATA,
 		RV_DRAWABLE_UNIQUE_PIPELINE
 	};
 
@@ -65,6 +76,7 @@ namespace rv
 			static constexpr bool has_data() { return meta.contain(RV_DRAWABLE_DATA); }
 			static constexpr bool has_renderer_data() { return meta.contain(RV_DRAWABLE_RENDERER_DATA); }
 			static constexpr bool has_image_data() { return meta.contain(RV_DRAWABLE_IMAGE_DATA); }
+			static constexpr bool has_static_image_data() { return meta.contain(RV_DRAWABLE_STATIC_IMAGE_DATA); }
 			static constexpr bool has_unique_pipeline() { return  meta.contain(RV_DRAWABLE_UNIQUE_PIPELINE); }
 			static constexpr bool has_static_pipeline() { return !meta.contain(RV_DRAWABLE_UNIQUE_PIPELINE); }
 		}
@@ -80,6 +92,7 @@ namespace rv
 		drawable.info.has_data();
 		drawable.info.has_renderer_data();
 		drawable.info.has_image_data();
+		drawable.info.has_static_image_data();
 		drawable.info.has_unique_pipeline();
 		drawable.info.has_static_pipeline();
 		drawable.id();
@@ -93,6 +106,7 @@ namespace rv
 	template<typename D> concept DrawableData			= DrawableConcept<D> && D::Info::has_data();
 	template<typename D> concept DrawableRendererData	= DrawableConcept<D> && D::Info::has_renderer_data();
 	template<typename D> concept DrawableImageData		= DrawableConcept<D> && D::Info::has_image_data();
+	template<typename D> concept DrawableStaticImageData	= DrawableConcept<D> && D::Info::has_static_image_data();
 	template<typename D> concept DrawableStaticPipeline	= DrawableConcept<D> && D::Info::has_static_pipeline();
 	template<typename D> concept DrawableUniquePipeline	= DrawableConcept<D> && D::Info::has_unique_pipeline();
 }
\ No newline at end of file
@@ -0,0 +1,74 @@
+#pragma once
+#include "Engine/Utility/SparseSet.h"
+#include <memory>
+#include <atomic>
+
+namespace rv
+{
+	/*
+		One SparseSet per data type, keyed by Drawable::id().
+		A type can own several pools through the slot index (e.g. one per swap chain image).
+	*/
+	class DrawablePools
+	{
+	public:
+		DrawablePools() = default;
+		DrawablePools(const DrawablePools&) = delete;
+		DrawablePools(DrawablePools&&) noexcept = default;
+
+		DrawablePools& operator= (const DrawablePools&) = delete;
+		DrawablePools& operator= (DrawablePools&&) noexcept = default;
+
+		template<typename T>
+		SparseSet<T>& Get(u32 slot = 0)
+		{
+			const size_t type = TypeIndex<T>();
+			if (type >= pools.size())
+				pools.resize(type + 1);
+			auto& slots = pools[type];
+			if (slot >= slots.size())
+				slots.resize((size_t)slot + 1);
+			if (!slots[slot])
+				slots[slot] = std::make_unique<Pool<T>>();
+			return static_cast<Pool<T>*>(slots[slot].get())->set;
+		}
+
+		void Erase(u32 id)
+		{
+			for (auto& slots : pools)
+				for (auto& pool : slots)
+					if (pool)
+						pool->Erase(id);
+		}
+
+		void Clear()
+		{
+			pools.clear();
+		}
+
+	private:
+		struct PoolBase
+		{
+			virtual ~PoolBase() = default;
+			virtual void Erase(u32 id) = 0;
+		};
+
+		template<typename T>
+		struct Pool : public PoolBase
+		{
+			void Erase(u32 id) override { set.erase(id); }
+			SparseSet<T> set;
+		};
+
+		template<typename T>
+		static size_t TypeIndex()
+		{
+			static const size_t index = nextType++;
+			return index;
+		}
+
+		std::vector<std::vector<std::unique_ptr<PoolBase>>> pools;
+
+		static inline std::atomic<size_t> nextType = 0;
+	};
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include "Engine/Drawable/Drawable.h"
+#include "Engine/Graphics/UniformArena.h"
+#include <deque>
+
+namespace rv
+{
+	typedef u32 ShapeMesh;
+
+	/*
+		Shape that shares its geometry with every other instance of the same mesh.
+		The position, scale and color of all instances are written to one per-instance vertex buffer,
+		each mesh is then drawn with a single DrawIndexed call.
+	*/
+	class InstancedShape : public DrawableType<InstancedShape, RV_DRAWABLE_DATA, RV_DRAWABLE_STATIC_IMAGE_DATA, RV_DRAWABLE_STATIC_DATA>
+	{
+	public:
+		InstancedShape() = default;
+
+		struct Instance : public InstanceVertex<1, VK_FORMAT_R32G32_SFLOAT, VK_FORMAT_R32G32_SFLOAT, VK_FORMAT_R32G32B32A32_SFLOAT>
+		{
+			Instance() = default;
+			Instance(const Vector2& position, const Vector2& scale, const FColor& color) : position(position), scale(scale), color(color) {}
+
+			Vector2 position;
+			Vector2 scale = { 1.0f, 1.0f };
+			FColor color = FColors::White;
+		};
+
+		struct Mesh
+		{
+			VertexBuffer vertexBuffer;
+			IndexBuffer indexBuffer;
+			u32 nIndices = 0;
+		};
+
+		struct StaticData
+		{
+			std::deque<Mesh> meshes;
+			// Scratch space for grouping the instances by mesh in Update, first instance of each mesh
+			std::vector<u32> offsets;
+		};
+
+		struct Data
+		{
+			ShapeMesh mesh = 0;
+			Instance instance;
+		};
+
+		struct StaticImageData
+		{
+			UniformArena instances;
+		};
+
+		static Result CreateMesh(ShapeMesh& mesh, Graphics& graphics, StagingBufferManager& manager, const HeapBuffer<Vertex2>& vertices, const HeapBuffer<u16>& indices);
+		static Result Create(InstancedShape& shape, Graphics& graphics, ShapeMesh mesh, const Instance& instance);
+
+		// Grows the image's instance buffer to fit every instance, the image must not be in flight
+		static Result InitImageData(Graphics& graphics, Renderer& renderer, const Device& device, const MemoryAllocator& memory, u32 image);
+
+		static void Update(Graphics& graphics, Renderer& renderer, u32 image);
+		// Every mesh is a work unit, it draws all of its instances
+		static u32 Count(Graphics& graphics);
+		// Recording can run on several threads at once, so it groups the instances into its own offsets
+		static void RecordCommand(CommandBuffer& draw, Graphics& graphics, Renderer& renderer, const DrawableRecorder& recorder, u32 image, DrawableRange range);
+		static void DescribePipeline(Graphics& graphics, PipelineLayoutDescriptor& layout, u32 index);
+
+		static constexpr u32 nPipelines = 1;
+	};
+}
@@ -1,9 +1,11 @@
 #pragma once
 #include "Engine/Drawable/Drawable.h"
+#include "Engine/Graphics/UniformArena.h"
+#include "Engine/Graphics/UploadQueue.h"
 
 namespace rv
 {
-	class Shape : public DrawableType<Shape, RV_DRAWABLE_DATA, RV_DRAWABLE_IMAGE_DATA, RV_DRAWABLE_STATIC_DATA>
+	class Shape : public DrawableType<Shape, RV_DRAWABLE_DATA, RV_DRAWABLE_STATIC_IMAGE_DATA, RV_DRAWABLE_STATIC_DATA>
 	{
 	public:
 		Shape() = default;
@@ -11,6 +13,8 @@ namespace rv
 		struct StaticData
 		{
 			DescriptorSetAllocator::Queue* queue = nullptr;
+			// Reflected from triangle.vert, the vertices have to match Vertex2
+			VertexDescriptor vertex;
 		};
 
 		struct Data
@@ -20,22 +24,44 @@ namespace rv
 			MappedStagingBuffer<Vertex2> vertices;
 			MappedStagingBuffer<u16> indices;
 			FColor color = FColors::White;
+			// Cleared while the buffers are still on the upload queue, the shape isn't drawn until then
+			bool uploaded = true;
 		};
 
-		struct ImageData
+		// Buffers of a shape that are still streaming in on the upload queue
+		struct PendingUpload
 		{
+			Drawable shape;
+			std::future<Result> vertices;
+			std::future<Result> indices;
+		};
+
+		/*
+			One persistently mapped arena holds the colors of every shape for a swapchain image,
+			each shape selects its slot with a dynamic offset into the same descriptor set.
+		*/
+		struct StaticImageData
+		{
+			UniformArena colors;
 			DescriptorSet set;
-			UniformBuffer buffer;
-			StagingBuffer color;
 		};
 
-		static Result Create(Shape& shape, Graphics& graphics, const StagingBufferManager& manager, const HeapBuffer<Vertex2>& vertices, const HeapBuffer<u16>& indices, const FColor& color);
-		static Result Create(Shape& shape, Graphics& graphics, const StagingBufferManager& manager, HeapBuffer<Vertex2>&& vertices, HeapBuffer<u16>&& indices, const FColor& color);
+		static Result Create(Shape& shape, Graphics& graphics, StagingBufferManager& manager, const HeapBuffer<Vertex2>& vertices, const HeapBuffer<u16>& indices, const FColor& color);
+		static Result Create(Shape& shape, Graphics& graphics, StagingBufferManager& manager, HeapBuffer<Vertex2>&& vertices, HeapBuffer<u16>&& indices, const FColor& color);
+		// Queues the buffers on the upload queue instead of waiting for them, the shape is drawn once FinishUpload succeeded
+		static Result Create(Shape& shape, Graphics& graphics, StagingBufferManager& manager, UploadQueue& uploads, const HeapBuffer<Vertex2>& vertices, const HeapBuffer<u16>& indices, const FColor& color, PendingUpload& pending);
+		static Result Create(Shape& shape, Graphics& graphics, StagingBufferManager& manager, UploadQueue& uploads, HeapBuffer<Vertex2>&& vertices, HeapBuffer<u16>&& indices, const FColor& color, PendingUpload& pending);
+		// Returns false while the uploads are running. Once they are done result holds their outcome, the shape is marked uploaded when they succeeded.
+		static bool FinishUpload(Graphics& graphics, PendingUpload& pending, Result& result);
 
 		static Result InitStaticData(Graphics& graphics, DescriptorSetAllocator& allocator);
-		static Result InitImageData(Shape& shape, Graphics& graphics, Renderer& renderer, DescriptorSetAllocator& allocator, const StagingBufferManager& manager, u32 imageCount);
+		// Allocates the image's set and grows its arena to fit every shape, the image must not be in flight
+		static Result InitImageData(Graphics& graphics, Renderer& renderer, DescriptorSetAllocator& allocator, const Device& device, const MemoryAllocator& memory, u32 image);
 	
-		static void RecordCommand(CommandBuffer& draw, Graphics& graphics, Renderer& renderer, const DrawableRecorder& recorder, u32 image);
+		static void Update(Graphics& graphics, Renderer& renderer, u32 image);
+		// Every shape is a work unit
+		static u32 Count(Graphics& graphics);
+		static void RecordCommand(CommandBuffer& draw, Graphics& graphics, Renderer& renderer, const DrawableRecorder& recorder, u32 image, DrawableRange range);
 		static void DescribePipeline(Graphics& graphics, PipelineLayoutDescriptor& layout, u32 index);
 
 		static constexpr u32 nPipelines = 1;
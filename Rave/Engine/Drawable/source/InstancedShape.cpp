@@ -0,0 +1,108 @@
+#include "Engine/Drawable/InstancedShape.h"
+#include "Engine/Utility/Error.h"
+#include "Engine/Graphics/Graphics.h"
+#include "Engine/Graphics/Renderer.h"
+#include <algorithm>
+
+/*
+	Counts the instances of every mesh and turns the counts into the index of each mesh's first instance.
+	Update and RecordCommand both walk the same pool, so they agree on the layout of the instance buffer.
+*/
+static void group_instances(std::vector<rv::u32>& offsets, const rv::SparseSet<rv::InstancedShape::Data>& shapes, size_t nMeshes)
+{
+	offsets.assign(nMeshes + 1, 0);
+	for (rv::u32 i = 0; i < (rv::u32)shapes.size(); ++i)
+		offsets[shapes[i].mesh + 1]++;
+	for (size_t m = 1; m < offsets.size(); ++m)
+		offsets[m] += offsets[m - 1];
+}
+
+rv::Result rv::InstancedShape::CreateMesh(ShapeMesh& mesh, Graphics& graphics, StagingBufferManager& manager, const HeapBuffer<Vertex2>& vertices, const HeapBuffer<u16>& indices)
+{
+	rv_result;
+	StaticData& staticData = graphics.GetStaticData<InstancedShape>();
+	Mesh data;
+	data.nIndices = (u32)indices.size();
+	rv_rif(VertexBuffer::Create(data.vertexBuffer, manager, vertices.data(), vertices.size() * sizeof(Vertex2), VK_BUFFER_USAGE_TRANSFER_DST_BIT));
+	rv_rif(IndexBuffer::Create(data.indexBuffer, manager, indices.data(), indices.size() * sizeof(u16), VK_INDEX_TYPE_UINT16, VK_BUFFER_USAGE_TRANSFER_DST_BIT));
+	mesh = (ShapeMesh)staticData.meshes.size();
+	staticData.meshes.push_back(std::move(data));
+	return result;
+}
+
+rv::Result rv::InstancedShape::Create(InstancedShape& shape, Graphics& graphics, ShapeMesh mesh, const Instance& instance)
+{
+	rv_result;
+	rif_check_info(mesh < graphics.GetStaticData<InstancedShape>().meshes.size(), "Invalid ShapeMesh");
+	Data& data = graphics.GetData(shape);
+	data.mesh = mesh;
+	data.instance = instance;
+	return result;
+}
+
+rv::Result rv::InstancedShape::InitImageData(Graphics& graphics, Renderer& renderer, const Device& device, const MemoryAllocator& memory, u32 image)
+{
+	rv_result;
+	const u32 count = (u32)graphics.GetDataPool<InstancedShape>().size();
+	StaticImageData& imageData = renderer.GetStaticImageData<InstancedShape>(image);
+	if (count > imageData.instances.capacity)
+		rv_rif(UniformArena::Create(imageData.instances, device, memory, sizeof(Instance), std::max({ count, imageData.instances.capacity * 2, 256u }), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT));
+	return result;
+}
+
+void rv::InstancedShape::Update(Graphics& graphics, Renderer& renderer, u32 image)
+{
+	const SparseSet<Data>& shapes = graphics.GetDataPool<InstancedShape>();
+	StaticData& staticData = graphics.GetStaticData<InstancedShape>();
+	StaticImageData& imageData = renderer.GetStaticImageData<InstancedShape>(image);
+	if (shapes.size() > imageData.instances.capacity)
+		return;
+
+	group_instances(staticData.offsets, shapes, staticData.meshes.size());
+	for (u32 i = 0; i < (u32)shapes.size(); ++i)
+		imageData.instances.Get<Instance>(staticData.offsets[shapes[i].mesh]++) = shapes[i].instance;
+	imageData.instances.Flush();
+}
+
+rv::u32 rv::InstancedShape::Count(Graphics& graphics)
+{
+	return (u32)graphics.GetStaticData<InstancedShape>().meshes.size();
+}
+
+void rv::InstancedShape::RecordCommand(CommandBuffer& draw, Graphics& graphics, Renderer& renderer, const DrawableRecorder& recorder, u32 image, DrawableRange range)
+{
+	const SparseSet<Data>& shapes = graphics.GetDataPool<InstancedShape>();
+	const StaticData& staticData = graphics.GetStaticData<InstancedShape>();
+	const StaticImageData& imageData = renderer.GetStaticImageData<InstancedShape>(image);
+	if (shapes.size() == 0 || shapes.size() > imageData.instances.capacity)
+		return;
+
+	std::vector<u32> offsets;
+	group_instances(offsets, shapes, staticData.meshes.size());
+	draw.BindVertexBuffer(imageData.instances.buffer, 1);
+	const size_t end = std::min<size_t>(range.first + range.count, staticData.meshes.size());
+	for (size_t m = range.first; m < end; ++m)
+	{
+		const u32 first = offsets[m];
+		const u32 count = offsets[m + 1] - first;
+		if (count == 0)
+			continue;
+
+		const Mesh& mesh = staticData.meshes[m];
+		draw.BindVertexBuffer(mesh.vertexBuffer);
+		draw.BindIndexBuffer(mesh.indexBuffer);
+		draw.DrawIndexed(mesh.nIndices, count, 0, 0, first);
+	}
+}
+
+void rv::InstancedShape::DescribePipeline(Graphics& graphics, PipelineLayoutDescriptor& layout, u32 index)
+{
+	layout.shaders = {
+		"instanced.vert",
+		"instanced.frag"
+	};
+	layout.cullMode = VK_CULL_MODE_NONE;
+	layout.clockwise = true;
+	layout.vertex.Set<Vertex2, Instance>();
+	layout.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+}
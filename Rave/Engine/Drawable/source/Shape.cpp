@@ -3,88 +3,162 @@
 #include "Engine/Utility/Error.h"
 #include "Engine/Graphics/Graphics.h"
 #include "Engine/Graphics/Renderer.h"
+#include <algorithm>
 
 
-rv::Result rv::Shape::Create(Shape& shape, Graphics& graphics, const StagingBufferManager& manager, const HeapBuffer<Vertex2>& vertices, const HeapBuffer<u16>& indices, const FColor& color)
+static rv::Result create_buffers(rv::Shape::Data& data, rv::StagingBufferManager& manager, rv::u64 vertexSize, rv::u64 indexSize)
+{
+	rv_result;
+	rv_rif(rv::VertexBuffer::Create(data.vertexBuffer, *manager.allocator, vertexSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT));
+	rv_rif(rv::IndexBuffer::Create(data.indexBuffer, *manager.allocator, indexSize, VK_INDEX_TYPE_UINT16, VK_BUFFER_USAGE_TRANSFER_DST_BIT));
+	return result;
+}
+
+// Both requests copy the data, so the staging buffers are free to change while they run
+static void queue_uploads(rv::Shape& shape, rv::Shape::Data& data, rv::UploadQueue& uploads, rv::Shape::PendingUpload& pending)
+{
+	data.uploaded = false;
+	pending.shape = shape;
+	pending.vertices = uploads.Upload(data.vertexBuffer, data.vertices.data);
+	pending.indices = uploads.Upload(data.indexBuffer, data.indices.data);
+}
+
+static rv::Result upload_buffers(rv::Shape::Data& data, rv::StagingBufferManager& manager)
+{
+	rv_result;
+	manager.BeginBatch();
+	result = data.vertices.Copy();
+	if (result.succeeded())
+		result = data.indices.Copy();
+	rv::Result end = manager.EndBatch();
+	return result.failed() ? result : end;
+}
+
+rv::Result rv::Shape::Create(Shape& shape, Graphics& graphics, StagingBufferManager& manager, const HeapBuffer<Vertex2>& vertices, const HeapBuffer<u16>& indices, const FColor& color)
+{
+	rv_result;
+	Data& data = graphics.GetData(shape);
+	data.color = color;
+	rv_rif(create_buffers(data, manager, vertices.size() * sizeof(Vertex2), indices.size() * sizeof(u16)));
+	rv_rif(MappedStagingBuffer<Vertex2>::Create(data.vertices, manager, data.vertexBuffer, vertices));
+	rv_rif(MappedStagingBuffer<u16>::Create(data.indices, manager, data.indexBuffer, indices));
+	return upload_buffers(data, manager);
+}
+
+rv::Result rv::Shape::Create(Shape& shape, Graphics& graphics, StagingBufferManager& manager, HeapBuffer<Vertex2>&& vertices, HeapBuffer<u16>&& indices, const FColor& color)
+{
+	rv_result;
+	Data& data = graphics.GetData(shape);
+	data.color = color;
+	rv_rif(create_buffers(data, manager, vertices.size() * sizeof(Vertex2), indices.size() * sizeof(u16)));
+	rv_rif(MappedStagingBuffer<Vertex2>::Create(data.vertices, manager, data.vertexBuffer, std::move(vertices)));
+	rv_rif(MappedStagingBuffer<u16>::Create(data.indices, manager, data.indexBuffer, std::move(indices)));
+	return upload_buffers(data, manager);
+}
+
+rv::Result rv::Shape::Create(Shape& shape, Graphics& graphics, StagingBufferManager& manager, UploadQueue& uploads, const HeapBuffer<Vertex2>& vertices, const HeapBuffer<u16>& indices, const FColor& color, PendingUpload& pending)
 {
 	rv_result;
 	Data& data = graphics.GetData(shape);
-	data.vertices.data = vertices;
-	data.indices.data = indices;
 	data.color = color;
-	rv_rif(VertexBuffer::Create(
-		data.vertexBuffer,
-		data.vertices,
-		manager,
-		data.vertices.data.data(),
-		data.vertices.ByteSize()
-	));
-	rv_rif(IndexBuffer::Create(
-		data.indexBuffer,
-		data.indices,
-		manager,
-		data.indices.data.data(),
-		data.indices.ByteSize(),
-		VK_INDEX_TYPE_UINT16
-	));
+	rv_rif(create_buffers(data, manager, vertices.size() * sizeof(Vertex2), indices.size() * sizeof(u16)));
+	rv_rif(MappedStagingBuffer<Vertex2>::Create(data.vertices, manager, data.vertexBuffer, vertices));
+	rv_rif(MappedStagingBuffer<u16>::Create(data.indices, manager, data.indexBuffer, indices));
+	queue_uploads(shape, data, uploads, pending);
 	return result;
 }
 
-rv::Result rv::Shape::Create(Shape& shape, Graphics& graphics, const StagingBufferManager& manager, HeapBuffer<Vertex2>&& vertices, HeapBuffer<u16>&& indices, const FColor& color)
+rv::Result rv::Shape::Create(Shape& shape, Graphics& graphics, StagingBufferManager& manager, UploadQueue& uploads, HeapBuffer<Vertex2>&& vertices, HeapBuffer<u16>&& indices, const FColor& color, PendingUpload& pending)
 {
 	rv_result;
 	Data& data = graphics.GetData(shape);
-	data.vertices.data = std::move(vertices);
-	data.indices.data = std::move(indices);
 	data.color = color;
-	rv_rif(VertexBuffer::Create(
-		data.vertexBuffer,
-		data.vertices,
-		manager,
-		data.vertices.data.data(),
-		data.vertices.ByteSize()
-	));
-	rv_rif(IndexBuffer::Create(
-		data.indexBuffer,
-		data.indices,
-		manager,
-		data.indices.data.data(),
-		data.indices.ByteSize(),
-		VK_INDEX_TYPE_UINT16
-	));
+	rv_rif(create_buffers(data, manager, vertices.size() * sizeof(Vertex2), indices.size() * sizeof(u16)));
+	rv_rif(MappedStagingBuffer<Vertex2>::Create(data.vertices, manager, data.vertexBuffer, std::move(vertices)));
+	rv_rif(MappedStagingBuffer<u16>::Create(data.indices, manager, data.indexBuffer, std::move(indices)));
+	queue_uploads(shape, data, uploads, pending);
 	return result;
 }
 
+bool rv::Shape::FinishUpload(Graphics& graphics, PendingUpload& pending, Result& result)
+{
+	constexpr auto now = std::chrono::seconds(0);
+	if (pending.vertices.wait_for(now) != std::future_status::ready || pending.indices.wait_for(now) != std::future_status::ready)
+		return false;
+
+	result = pending.vertices.get();
+	Result indices = pending.indices.get();
+	if (result.succeeded())
+		result = indices;
+	if (result.succeeded())
+		graphics.GetDataInterpreted<Shape>(pending.shape).uploaded = true;
+	return true;
+}
+
 rv::Result rv::Shape::InitStaticData(Graphics& graphics, DescriptorSetAllocator& allocator)
 {
+	rv_result;
 	StaticData& staticData = graphics.GetStaticData<Shape>();
+	Shader* vertex;
+	Shader* fragment;
+	rv_rif(graphics.GetShader(vertex, "triangle.vert"));
+	rv_rif(graphics.GetShader(fragment, "triangle.frag"));
+	rif_check_info(vertex->reflection.vertexBinding.stride == sizeof(Vertex2), "triangle.vert doesn't take a Vertex2");
+	staticData.vertex.Set(vertex->reflection);
+
+	// Every shape's color lives in one arena, selected with a dynamic offset
 	DescriptorSetBindings bindings;
-	bindings.AddBinding(RV_ST_FRAGMENT, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
+	rv_rif(bindings.AddShader(*vertex, 0, true));
+	rv_rif(bindings.AddShader(*fragment, 0, true));
 	return allocator.GetQueue(staticData.queue, bindings);
 }
 
-rv::Result rv::Shape::InitImageData(Shape& shape, Graphics& graphics, Renderer& renderer, DescriptorSetAllocator& allocator, const StagingBufferManager& manager, u32 imageCount)
+rv::Result rv::Shape::InitImageData(Graphics& graphics, Renderer& renderer, DescriptorSetAllocator& allocator, const Device& device, const MemoryAllocator& memory, u32 image)
 {
 	rv_result;
-	Data& data = graphics.GetData(shape);
 	StaticData& staticData = graphics.GetStaticData<Shape>();
-	for (u32 i = 0; i < imageCount; ++i)
-	{
-		ImageData& image = renderer.GetImageData(shape, i);
-		rv_rif(UniformBuffer::Create(image.buffer, image.color, manager, &data.color, sizeof(FColor)));
-		rv_rif(allocator.Allocate(image.set, *staticData.queue));
-		image.set.Write(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, image.buffer, sizeof(FColor), 0, 0);
-	}
+	StaticImageData& imageData = renderer.GetStaticImageData<Shape>(image);
+	const u32 count = (u32)graphics.GetDataPool<Shape>().size();
+	if (!imageData.set.set)
+		rv_rif(allocator.Allocate(imageData.set, *staticData.queue));
+	if (count <= imageData.colors.capacity)
+		return result;
+
+	// The set is rewritten once the arena grows
+	rv_rif(UniformArena::Create(imageData.colors, device, memory, sizeof(FColor), std::max({ count, imageData.colors.capacity * 2, 64u })));
+	imageData.set.Write(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, imageData.colors.buffer, sizeof(FColor), 0, 0);
 	return result;
 }
 
-void rv::Shape::RecordCommand(CommandBuffer& draw, Graphics& graphics, Renderer& renderer, const DrawableRecorder& recorder, u32 image)
+void rv::Shape::Update(Graphics& graphics, Renderer& renderer, u32 image)
+{
+	const SparseSet<Data>& shapes = graphics.GetDataPool<Shape>();
+	StaticImageData& imageData = renderer.GetStaticImageData<Shape>(image);
+	for (u32 i = 0; i < (u32)shapes.size() && i < imageData.colors.capacity; ++i)
+		imageData.colors.Get<FColor>(i) = shapes[i].color;
+	imageData.colors.Flush();
+}
+
+rv::u32 rv::Shape::Count(Graphics& graphics)
 {
-	const Data& data = graphics.GetDataInterpreted<Shape>(recorder.drawable);
-	draw.BindDescriptorSet(renderer.GetImageDataInterpreted<Shape>(recorder.drawable, image).set, recorder.pipeline->layout);
-	draw.BindVertexBuffer(data.vertexBuffer);
-	draw.BindIndexBuffer(data.indexBuffer);
-	draw.DrawIndexed(data.indices.Size());
+	return (u32)graphics.GetDataPool<Shape>().size();
+}
+
+void rv::Shape::RecordCommand(CommandBuffer& draw, Graphics& graphics, Renderer& renderer, const DrawableRecorder& recorder, u32 image, DrawableRange range)
+{
+	const SparseSet<Data>& shapes = graphics.GetDataPool<Shape>();
+	const StaticImageData& imageData = renderer.GetStaticImageData<Shape>(image);
+	const u32 end = std::min(range.first + range.count, (u32)shapes.size());
+	for (u32 i = range.first; i < end; ++i)
+	{
+		const Data& data = shapes[i];
+		if (!data.uploaded)
+			continue;
+		draw.BindDescriptorSet(imageData.set, recorder.pipeline->layout, imageData.colors.Offset(i));
+		draw.BindVertexBuffer(data.vertexBuffer);
+		draw.BindIndexBuffer(data.indexBuffer);
+		draw.DrawIndexed(data.indices.Size());
+	}
 }
 
 void rv::Shape::DescribePipeline(Graphics& graphics, PipelineLayoutDescriptor& layout, u32 index)
@@ -95,7 +169,7 @@ void rv::Shape::DescribePipeline(Graphics& graphics, PipelineLayoutDescriptor& l
 	};
 	layout.cullMode = VK_CULL_MODE_NONE;
 	layout.clockwise = true;
-	layout.vertex.Set<Vertex2>();
+	layout.vertex = graphics.GetStaticData<Shape>().vertex;
 	layout.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
 	layout.AddLayout(graphics.GetStaticData<Shape>().queue->layout);
 }
\ No newline at end of file
@@ -21,8 +21,8 @@ namespace rv
 
 		static Result Create(Buffer& buffer, const MemoryAllocator& allocator, u64 size, VkBufferUsageFlags bufferUsage, VmaMemoryUsage memoryUsage);
 		static Result Create(Buffer& buffer, const MemoryAllocator& allocator, const void* data, u64 size, VkBufferUsageFlags bufferUsage, VmaMemoryUsage memoryUsage);
-		static Result Create(Buffer& buffer, const StagingBufferManager& manager, const void* data, u64 size, VkBufferUsageFlags bufferUsage, VmaMemoryUsage memoryUsage);
-		static Result Create(Buffer& buffer, StagingBuffer& staging, const StagingBufferManager& manager, const void* data, u64 size, VkBufferUsageFlags bufferUsage, VmaMemoryUsage memoryUsage);
+		static Result Create(Buffer& buffer, StagingBufferManager& manager, const void* data, u64 size, VkBufferUsageFlags bufferUsage, VmaMemoryUsage memoryUsage);
+		static Result Create(Buffer& buffer, StagingBuffer& staging, StagingBufferManager& manager, const void* data, u64 size, VkBufferUsageFlags bufferUsage, VmaMemoryUsage memoryUsage);
 
 
 		Result Map(const void* data, u64 size) const;
@@ -70,11 +70,11 @@ namespace rv
 		{
 			return Buffer::Create(buffer, allocator, data, size, bufferUsage | T, memoryUsage);
 		}
-		static Result Create(TypedBuffer& buffer, const StagingBufferManager& manager, const void* data, u64 size, VkBufferUsageFlags bufferUsage = 0, VmaMemoryUsage memoryUsage = U)
+		static Result Create(TypedBuffer& buffer, StagingBufferManager& manager, const void* data, u64 size, VkBufferUsageFlags bufferUsage = 0, VmaMemoryUsage memoryUsage = U)
 		{
 			return Buffer::Create(buffer, manager, data, size, bufferUsage | T, memoryUsage);
 		}
-		static Result Create(TypedBuffer& buffer, StagingBuffer& staging, const StagingBufferManager& manager, const void* data, u64 size, VkBufferUsageFlags bufferUsage = 0, VmaMemoryUsage memoryUsage = U)
+		static Result Create(TypedBuffer& buffer, StagingBuffer& staging, StagingBufferManager& manager, const void* data, u64 size, VkBufferUsageFlags bufferUsage = 0, VmaMemoryUsage memoryUsage = U)
 		{
 			return Buffer::Create(buffer, staging, manager, data, size, bufferUsage | T, memoryUsage);
 		}
@@ -8,6 +8,7 @@
 #include "Engine/Utility/Color.h"
 #include "Engine/Graphics/Buffer.h"
 #include "Engine/Graphics/IndexBuffer.h"
+#include "Engine/Graphics/Image.h"
 #include "Engine/Graphics/DescriptorSet.h"
 
 namespace rv
@@ -42,27 +43,40 @@ namespace rv
 
 		void Release();
 
-		static Result Create(CommandBuffer& buffer, const Device& device, const CommandPool& pool);
-		static Result Create(std::vector<std::reference_wrapper<CommandBuffer>> buffers, const Device& device, const CommandPool& pool);
+		static Result Create(CommandBuffer& buffer, const Device& device, const CommandPool& pool, VkCommandBufferLevel level = VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+		static Result Create(std::vector<std::reference_wrapper<CommandBuffer>> buffers, const Device& device, const CommandPool& pool, VkCommandBufferLevel level = VK_COMMAND_BUFFER_LEVEL_PRIMARY);
 
 		Result Begin(bool once = false) const;
+		// Begins a secondary command buffer that continues the given render pass
+		Result Begin(const RenderPass& pass, const FrameBuffer& frame, u32 subpass = 0) const;
 		Result End() const;
 		void StartRenderPass(
 			const RenderPass& pass,
 			const FrameBuffer& frame,
 			const Point& offset,
 			const Extent2D& size,
-			const FColor& color = FColors::Transparent
+			const FColor& color = FColors::Transparent,
+			VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE
 		) const;
 		void EndRenderPass() const;
+		// Sets the dynamic viewport and scissor to cover the whole target
+		void SetViewport(const Extent2D& size) const;
+		void ExecuteCommands(const std::vector<CommandBuffer>& buffers) const;
+		void ExecuteCommands(const CommandBuffer* buffers, u32 count) const;
 		void BindPipeline(const Pipeline& pipeline) const;
 		void BindVertexBuffer(const VertexBuffer& vertices) const;
+		void BindVertexBuffer(const Buffer& vertices, u32 binding, u64 offset = 0) const;
 		void BindIndexBuffer(const IndexBuffer& indices) const;
 		void BindDescriptorSet(const DescriptorSet& set, const PipelineLayout& layout, PipelineType type = RV_PT_GRAPHICS);
+		void BindDescriptorSet(const DescriptorSet& set, const PipelineLayout& layout, u32 dynamicOffset, PipelineType type = RV_PT_GRAPHICS);
 		void Draw(u32 nVertices, u32 nInstances = 1, u32 vertexOffset = 0, u32 instanceOffset = 0) const;
 		void DrawIndexed(u32 nIndices, u32 nInstances = 1, u32 vertexOffset = 0, u32 indexOffset = 0, u32 instanceOffset = 0) const;
 
 		void CopyBuffers(const Buffer& source, const Buffer& dest, u64 size, u64 srcOffset = 0, u64 destOffset = 0);
+		// Copies the whole image, which must be in VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, into tightly packed rows
+		void CopyImageToBuffer(const Image& source, const Buffer& dest) const;
+		// Makes earlier transfer writes to the buffer visible to the host once the submit has finished
+		void HostReadBarrier(const Buffer& dest) const;
 
 		Result Submit(const Fence* fence = nullptr) const;
 		Result Submit(const Queue& queue, const Fence* fence = nullptr) const;
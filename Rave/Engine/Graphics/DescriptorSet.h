@@ -3,7 +3,7 @@
 #include "Engine/Graphics/Shader.h"
 #include "Engine/Graphics/Buffer.h"
 #include <map>
-#include <queue>
+#include <unordered_map>
 
 namespace rv
 {
@@ -12,8 +12,21 @@ namespace rv
 		DescriptorSetBindings() = default;
 
 		void AddBinding(Flags<ShaderType, u32> shaderTypes, VkDescriptorType type, u32 count = 1);
+		/*
+			Adds the shader's reflected bindings of the set, merging the stage flags of bindings that are already present.
+			Reflection can't tell whether a buffer gets a dynamic offset, dynamic turns every uniform and storage buffer into the dynamic type.
+		*/
+		Result AddShader(const Shader& shader, u32 set = 0, bool dynamic = false);
 
 		int operator<=> (const DescriptorSetBindings& rhs) const;
+		bool operator== (const DescriptorSetBindings& rhs) const;
+
+		size_t Hash() const;
+
+		struct Hasher
+		{
+			size_t operator() (const DescriptorSetBindings& bindings) const { return bindings.Hash(); }
+		};
 
 		std::vector<VkDescriptorSetLayoutBinding> bindings;
 	};
@@ -57,7 +70,8 @@ namespace rv
 		DescriptorPool& operator= (const DescriptorPool&) = delete;
 		DescriptorPool& operator= (DescriptorPool&& rhs) noexcept;
 
-		static Result Create(DescriptorPool& pool, const Device& device, const DescriptorPoolSizes& sizes);
+		// maxSets 0 allows as many sets as there are descriptors
+		static Result Create(DescriptorPool& pool, const Device& device, const DescriptorPoolSizes& sizes, u32 maxSets = 0);
 
 		Result Allocate(DescriptorSet& set, const DescriptorSetLayout& layout);
 		Result Allocate(std::vector<std::reference_wrapper<DescriptorSet>>& sets, const DescriptorSetLayout& layout);
@@ -65,6 +79,8 @@ namespace rv
 
 		Result Free(DescriptorSet& set);
 		Result Free(std::vector<std::reference_wrapper<DescriptorSet>>& sets);
+		// Returns every set to the pool at once, the sets allocated from it become invalid
+		Result Reset();
 
 		void Release();
 
@@ -89,13 +105,18 @@ namespace rv
 		const Device* device = nullptr;
 	};
 
+	/*
+		Caches one layout per set of bindings and allocates its sets from pools that double in size, up to max_pool_sets.
+		Freed sets go on a free list and are handed out again before the pools are touched, so no pool needs
+		VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT. Reset returns every set at once.
+	*/
 	class DescriptorSetAllocator
 	{
 	public:
 		DescriptorSetAllocator() = default;
-		DescriptorSetAllocator(Device& device);
+		DescriptorSetAllocator(const Device& device);
 
-		void SetDevice(Device& device);
+		void SetDevice(const Device& device);
 
 	public:
 		struct Entry
@@ -111,20 +132,50 @@ namespace rv
 		{
 			Queue() = default;
 
-			Result NextPool(DescriptorPool*& pool, Device& device);
+			// Fills sets with count sets, with one vkAllocateDescriptorSets call per pool they come from.
+			// On failure every set it got hold of is back on the free list.
+			Result Allocate(VkDescriptorSet* sets, u32 count, const Device& device);
+			/*
+				The set has to come from this queue, it is reused as is so the caller rewrites it.
+				It is handed out again right away, so no pending command buffer may still use it.
+			*/
+			void Free(VkDescriptorSet set);
+			Result Reset();
 
 			DescriptorSetLayout layout;
+			// The descriptors of a single set
 			DescriptorPoolSizes entrySizes;
-			std::queue<Entry> entries;
-			u32 size = 0;
+			std::vector<Entry> entries;
+			std::vector<VkDescriptorSet> free;
+			// Sets in the next pool
+			u32 size = first_pool_sets;
+			// Every entry before this one is full
+			size_t current = 0;
+
+		private:
+			// Advances sets and lowers count as the pools hand them out
+			Result AllocateFromPools(VkDescriptorSet*& sets, u32& count, const Device& device);
+			Result NextPool(const Device& device);
+
+		private:
+			std::vector<VkDescriptorSetLayout> layouts;
 		};
 
 		Result GetQueue(Queue*& queue, const DescriptorSetBindings& bindings);
 		Result Allocate(DescriptorSet& set, const DescriptorSetBindings& bindings);
+		// A set that is still allocated goes back to the queue first, so it has to come from the same queue
 		Result Allocate(DescriptorSet& set, Queue& queue);
+		Result Allocate(std::vector<std::reference_wrapper<DescriptorSet>>& sets, Queue& queue);
+		// Wait for the command buffers that bound the set first, see Queue::Free
+		void Free(DescriptorSet& set, Queue& queue);
+		// Resets the pools of every queue, the layouts stay cached
+		Result Reset();
+
+		static constexpr u32 first_pool_sets = 16;
+		static constexpr u32 max_pool_sets = 4096;
 
 	private:
-		std::map<DescriptorSetBindings, Queue> queues;
-		Device* device = nullptr;
+		std::unordered_map<DescriptorSetBindings, Queue, DescriptorSetBindings::Hasher> queues;
+		const Device* device = nullptr;
 	};
 }
\ No newline at end of file
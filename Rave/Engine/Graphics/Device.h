@@ -6,6 +6,8 @@
 #include <array>
 #include <map>
 #include <list>
+#include <mutex>
+#include <memory>
 
 namespace rv
 {
@@ -68,9 +70,13 @@ namespace rv
 		void Release();
 		Result Wait() const;
 
+		// vkQueueSubmit, vkQueuePresentKHR and vkQueueWaitIdle need the VkQueue to be externally synchronized
+		std::unique_lock<std::mutex> Lock() const;
+
 		VkQueue queue = VK_NULL_HANDLE;
 		u32 family = std::numeric_limits<u32>::max();
 		u32 index = std::numeric_limits<u32>::max();
+		std::mutex* mutex = nullptr;	// shared by every Queue with the same VkQueue, owned by the Device
 	};
 
 	enum QueueGetterType
@@ -193,6 +199,12 @@ namespace rv
 		Queue graphicsQueue;
 		Queue computeQueue;
 		Extensions extensions;
+
+	private:
+		std::mutex* QueueMutex(VkQueue queue) const;
+
+		// Only filled while queues are retrieved, which happens before the device is shared between threads
+		mutable std::map<VkQueue, std::unique_ptr<std::mutex>> queueMutexes;
 	};
 
 	template<typename T>
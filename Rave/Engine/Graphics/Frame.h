@@ -13,8 +13,8 @@ namespace rv
 		void SetSwapChain(SwapChain& swap);
 
 		Result Start(u32& image, bool& resized);
+		// Submits the whole frame, waits for the image and signals the fence and the present semaphore
 		Result Render(const CommandBuffer& drawCommand);
-		Result RenderLast(const CommandBuffer& drawCommand);
 		Result End(bool& resized);
 
 		Result Wait() const;
@@ -32,6 +32,5 @@ namespace rv
 		Semaphore imageAvailable;
 		Semaphore renderFinished;
 		Fence inFlight;
-		bool first = false;
 	};
 }
\ No newline at end of file
@@ -6,16 +6,22 @@
 #include "Engine/Core/Window.h"
 #include "Engine/Graphics/SwapChain.h"
 #include "Engine/Graphics/Shader.h"
+#include "Engine/Graphics/ShaderArchive.h"
 #include "Engine/Utility/File.h"
 #include "Engine/Graphics/Pipeline.h"
 #include "Engine/Drawable/Drawable.h"
 #include "Engine/Graphics/MemoryAllocator.h"
 #include "Engine/Drawable/Shape.h"
+#include "Engine/Drawable/InstancedShape.h"
 #include "Engine/Graphics/CommandPool.h"
 #include "Engine/Graphics/StagingBuffer.h"
+#include "Engine/Graphics/UploadQueue.h"
 #include "Engine/Utility/Multimap.h"
+#include "Engine/Drawable/DrawablePool.h"
 #include "Engine/Graphics/DescriptorSet.h"
+#include "Engine/Utility/JobSystem.h"
 #include <set>
+#include <unordered_map>
 
 namespace rv
 {
@@ -27,6 +33,10 @@ namespace rv
 		GraphicsInfo(const std::vector<std::reference_wrapper<const Window>>& windows, const ApplicationInfo& app = {});
 
 		ApplicationInfo app;
+		// Where the pipeline cache is kept between runs
+		std::filesystem::path cacheDirectory;
+		// Enables no surface or swap chain extensions, for renderers without a window like the OffscreenRenderer
+		bool headless = false;
 		std::vector<std::reference_wrapper<const Surface>> surfaces;
 		std::vector<std::reference_wrapper<const Window>> windows;
 	};
@@ -35,27 +45,65 @@ namespace rv
 	{
 	public:
 		Graphics() = default;
-		static Result Create(Graphics& graphics, const GraphicsInfo& info = {});
+		static Result Create(Graphics& graphics, const GraphicsInfo& info = {}, JobSystem* jobs = nullptr);
 
 		Result GetShader(Shader*& shader, const char* name, ShaderType type = RV_ST_NULL);
+		// Creates every shader that isn't loaded yet in parallel
+		Result LoadShaders(const std::vector<const char*>& names);
+		// Creates every indexed shader that isn't loaded yet in parallel
+		Result LoadShaders();
 		Result CreateShader(const char* name, ShaderType type = RV_ST_NULL);
+		// Indexes the compiled shaders (<name>.spv) in the directory and its bin folder, earlier paths take precedence.
+		// A shaders.rvsa archive in the directory is added as well.
 		Result AddShaderPath(const char* path);
+		// Shaders in archives take precedence over loose files, earlier archives over later ones
+		Result AddShaderArchive(const std::filesystem::path& path);
 
 		template<DrawableStaticData D>	
-		D::StaticData& GetStaticData() { return drawableData.get<D::StaticData>(); }
+		D::StaticData& GetStaticData() { return staticData.get<D::StaticData>(); }
 		template<DrawableData D>	
-		D::Data& GetData(D& drawable) { return drawableData.get<D::Data>(drawable.id()); }
+		D::Data& GetData(D& drawable) { return drawableData.Get<typename D::Data>().get(drawable.id()); }
 		template<DrawableData D>
-		D::Data& GetDataInterpreted(Drawable drawable) { return drawableData.get<D::Data>(drawable.id()); }
+		D::Data& GetDataInterpreted(Drawable drawable) { return drawableData.Get<typename D::Data>().get(drawable.id()); }
+		template<DrawableData D>
+		SparseSet<typename D::Data>& GetDataPool() { return drawableData.Get<typename D::Data>(); }
 
 		Result CreateShape(Shape& shape, const HeapBuffer<Vertex2>& vertices, const HeapBuffer<u16>& indices, const FColor& color);
 		Result CreateShape(Shape& shape, HeapBuffer<Vertex2>&& vertices, HeapBuffer<u16>&& indices, const FColor& color);
+		// Streams the buffers in on the upload queue, the shape is only drawn once Shape::FinishUpload succeeded on pending
+		Result CreateShape(Shape& shape, const HeapBuffer<Vertex2>& vertices, const HeapBuffer<u16>& indices, const FColor& color, Shape::PendingUpload& pending);
+		Result CreateShape(Shape& shape, HeapBuffer<Vertex2>&& vertices, HeapBuffer<u16>&& indices, const FColor& color, Shape::PendingUpload& pending);
+		// Instanced shapes created from the same mesh share its vertex and index buffer
+		Result CreateShapeMesh(ShapeMesh& mesh, const HeapBuffer<Vertex2>& vertices, const HeapBuffer<u16>& indices);
+		Result CreateInstancedShape(InstancedShape& shape, ShapeMesh mesh, const InstancedShape::Instance& instance);
+
+		// Every upload between BeginUploads and EndUploads goes to the GPU in one submit
+		void BeginUploads();
+		Result EndUploads();
+		// Uploads on a background thread, rendering can continue while they stream in
+		UploadQueue& GetUploadQueue();
+		// Runs jobs inline when the Graphics wasn't given a JobSystem
+		JobSystem& Jobs();
 
 	private:
 		template<typename D>
 		bool InitStatic();
 
 		Drawable NewDrawable();
+		// Where the code of a shader comes from, an archive entry or a file
+		struct ShaderSource
+		{
+			const ShaderArchive* archive = nullptr;
+			const ShaderArchive::Entry* entry = nullptr;
+			std::filesystem::path path;
+			// The normalized name, owned by the archive or by shaderFiles so the shader map can key on it
+			const char* name = nullptr;
+		};
+
+		// Shaders found next to the working directory are added to shaderFiles
+		Result FindShader(ShaderSource& source, const char* name);
+		Result LoadShader(Shader& shader, const ShaderSource& source, ShaderType type) const;
+		void IndexShaders(const std::filesystem::path& directory);
 
 	private:
 
@@ -63,12 +111,20 @@ namespace rv
 		rv_debug_only(DebugMessenger debug;);
 		Device device;
 		MemoryAllocator allocator;
+		PipelineCache pipelineCache;
 		StagingBufferManager manager;
+		JobSystem* jobs = nullptr;
 
 		ShaderMap shaders;
 		std::vector<std::filesystem::path> shaderpaths;
+		// Shader name (lower case, without .spv) to its file, filled by AddShaderPath so lookups don't touch the file system
+		std::unordered_map<std::string, std::filesystem::path> shaderFiles;
+		std::vector<ShaderArchive> shaderArchives;
 
-		MultiMap drawableData;
+		MultiMap staticData;
+		DrawablePools drawableData;
+		// Destroyed before the drawables, its worker finishes the uploads into their buffers first
+		UploadQueue uploads;
 
 		uint lastDrawable = 0;
 		std::list<Drawable> freeDrawables;
@@ -80,6 +136,7 @@ namespace rv
 		friend class Engine;
 		friend class Renderer;
 		friend class WindowRenderer;
+		friend class OffscreenRenderer;
 		friend class GraphicsHelper;
 	};
 }
\ No newline at end of file
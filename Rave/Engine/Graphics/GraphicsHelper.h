@@ -1,44 +1,49 @@
 #pragma once
-#include "Engine/Graphics/WindowRenderer.h"
+#include "Engine/Graphics/Renderer.h"
 #include "Engine/Utility/Error.h"
 #include "Engine/Core/Engine.h"
 
 namespace rv
 {
 	template<DrawableConcept D>
-	Result WindowRenderer::AddDrawable(D& drawable)
+	Result Renderer::AddDrawable(D& drawable)
 	{
 		rv_result;
 		rif_assert(engine);
 		if constexpr (DrawableStaticPipeline<D>)
 		{
+			// The type's recorders draw every instance in its pool, so they only need re-recording.
+			// That happens for each image right before it is rendered, the frames in flight keep their commands.
 			if (initializedPipelines.contains(typeid(D).hash_code()))
+			{
+				Invalidate();
 				return result;
+			}
 
-			initializedPipelines.insert(typeid(D).hash_code());
+			// Only registered once every pipeline exists, a failed type is set up again by its next drawable
+			std::vector<DrawableRecorder> typeRecorders;
 			for (u32 i = 0; i < D::nPipelines; ++i)
 			{
 				rv::FullPipeline* pipeline;
 				rv::PipelineLayoutDescriptor layout;
 				drawable.DescribePipeline(engine->graphics, layout, i);
 				layout.Rehash();
-				GetPipeline(pipeline, layout);
+				rv_rif(GetPipeline(pipeline, layout));
 
 				DrawableRecorder recorder;
 				recorder.recordFunction = D::RecordCommand;
+				if constexpr (requires { D::Update; })
+					if (i == 0)
+						recorder.updateFunction = D::Update;
+				if constexpr (requires { D::Count; })
+					recorder.countFunction = D::Count;
 				recorder.drawable = drawable.id();
 				recorder.pipeline = pipeline;
-				recorder.commandIndex = (u32)drawCommands[0].size();
-				recorders.push_back(recorder);
-
-				for (size_t i = 0; i < drawCommands.size(); ++i)
-				{
-					CommandBuffer draw;
-					rv_rif(CommandBuffer::Create(draw, engine->graphics.device, drawPool));
-					rv_rif(Record(recorder, draw, i));
-					drawCommands[i].push_back(std::move(draw));
-				}
+				typeRecorders.push_back(recorder);
 			}
+			initializedPipelines.insert(typeid(D).hash_code());
+			recorders.insert(recorders.end(), typeRecorders.begin(), typeRecorders.end());
+			Invalidate();
 		}
 		else
 		{
@@ -0,0 +1,30 @@
+#pragma once
+#include "Engine/Graphics/Allocation.h"
+#include "Engine/Utility/Vector.h"
+
+namespace rv
+{
+	/*
+		2D image with a single mip level and layer, allocated through VMA.
+		Renderers without a swap chain render into these.
+	*/
+	struct Image
+	{
+		Image() = default;
+		Image(const Image&) = delete;
+		Image(Image&& rhs) noexcept;
+		~Image();
+
+		Image& operator= (const Image&) = delete;
+		Image& operator= (Image&& rhs) noexcept;
+
+		void Release();
+
+		static Result Create(Image& image, const MemoryAllocator& allocator, const Extent2D& size, VkFormat format, VkImageUsageFlags usage, VmaMemoryUsage memoryUsage = VMA_MEMORY_USAGE_GPU_ONLY);
+
+		VkImage image = VK_NULL_HANDLE;
+		Allocation allocation;
+		VkFormat format = VK_FORMAT_UNDEFINED;
+		Extent2D size;
+	};
+}
@@ -15,8 +15,8 @@ namespace rv
 
 		static Result Create(IndexBuffer& buffer, const MemoryAllocator& allocator, u64 size, VkIndexType type, VkBufferUsageFlags bufferUsage = 0, VmaMemoryUsage memoryUsage = VMA_MEMORY_USAGE_GPU_ONLY);
 		static Result Create(IndexBuffer& buffer, const MemoryAllocator& allocator, const void* data, u64 size, VkIndexType type, VkBufferUsageFlags bufferUsage = 0, VmaMemoryUsage memoryUsage = VMA_MEMORY_USAGE_GPU_ONLY);
-		static Result Create(IndexBuffer& buffer, const StagingBufferManager& manager, const void* data, u64 size, VkIndexType type, VkBufferUsageFlags bufferUsage = 0, VmaMemoryUsage memoryUsage = VMA_MEMORY_USAGE_GPU_ONLY);
-		static Result Create(IndexBuffer& buffer, StagingBuffer& staging, const StagingBufferManager& manager, const void* data, u64 size, VkIndexType type, VkBufferUsageFlags bufferUsage = 0, VmaMemoryUsage memoryUsage = VMA_MEMORY_USAGE_GPU_ONLY);
+		static Result Create(IndexBuffer& buffer, StagingBufferManager& manager, const void* data, u64 size, VkIndexType type, VkBufferUsageFlags bufferUsage = 0, VmaMemoryUsage memoryUsage = VMA_MEMORY_USAGE_GPU_ONLY);
+		static Result Create(IndexBuffer& buffer, StagingBuffer& staging, StagingBufferManager& manager, const void* data, u64 size, VkIndexType type, VkBufferUsageFlags bufferUsage = 0, VmaMemoryUsage memoryUsage = VMA_MEMORY_USAGE_GPU_ONLY);
 		
 		VkIndexType type = VK_INDEX_TYPE_UINT32;
 	};
@@ -0,0 +1,58 @@
+#pragma once
+#include "Engine/Graphics/Renderer.h"
+#include "Engine/Graphics/Image.h"
+#include "Engine/Graphics/ImageView.h"
+
+namespace rv
+{
+	/*
+		Renders into images it allocates itself instead of a swap chain, so it needs no window or presentation support.
+		Create the engine with GraphicsInfo::headless to leave out the surface and swap chain extensions.
+		Every frame is copied into a host visible buffer after its render pass, Read returns those pixels.
+	*/
+	class OffscreenRenderer : public Renderer
+	{
+	public:
+		OffscreenRenderer() = default;
+		~OffscreenRenderer();
+
+		static Result Create(
+			OffscreenRenderer& renderer,
+			Engine& engine,
+			const Extent2D& size,
+			const FColor& background = FColors::White,
+			u32 imageCount = 2,
+			VkFormat format = VK_FORMAT_R8G8B8A8_UNORM
+		);
+
+		// Submits the next image without waiting for it to finish
+		Result Render() override;
+		Result Wait() const override;
+		Result Resize(const Extent2D& size);
+
+		// Waits for the image and copies its pixels, rows of Size().width texels without padding
+		Result Read(std::vector<u8>& pixels, u32 image) const;
+		// Reads the image that was rendered last
+		Result Read(std::vector<u8>& pixels) const;
+
+		u32 CurrentImage() const override;
+		Extent2D Size() const;
+		VkFormat Format() const;
+		u32 TexelSize() const;
+
+	protected:
+		void RecordAfterPass(const CommandBuffer& draw, size_t image) const override;
+
+	private:
+		Result CreateImages();
+
+	private:
+		VkFormat format = VK_FORMAT_UNDEFINED;
+		std::vector<Image> images;
+		std::vector<ImageView> views;
+		std::vector<Buffer> readback;
+		std::vector<Fence> fences;
+		u32 nextImage = 0;
+		u32 current = Optional<u32>::invalid_value;
+	};
+}
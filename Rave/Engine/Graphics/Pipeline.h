@@ -4,6 +4,7 @@
 #include "Engine/Graphics/RenderPass.h"
 #include "Engine/Graphics/Vertex.h"
 #include "Engine/Graphics/DescriptorSet.h"
+#include "Engine/Graphics/PipelineCache.h"
 #include <type_traits>
 
 namespace rv
@@ -66,6 +67,8 @@ namespace rv
 
 		VkPipelineLayout layout = VK_NULL_HANDLE;
 		VkPipelineVertexInputStateCreateInfo vertexInput{};
+		std::vector<VkVertexInputBindingDescription> vertexBindings;
+		std::vector<VkVertexInputAttributeDescription> vertexAttributes;
 		VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
 		VkViewport viewport{};
 		VkRect2D scissor{};
@@ -74,9 +77,13 @@ namespace rv
 		VkPipelineMultisampleStateCreateInfo multisampling{};
 		VkPipelineColorBlendAttachmentState colorBlendAttachment{};
 		VkPipelineColorBlendStateCreateInfo colorBlending{};
+		// Viewport and scissor are set while recording, so a resize doesn't invalidate the pipeline
+		VkPipelineDynamicStateCreateInfo dynamicState{};
 		std::vector<VkPipelineShaderStageCreateInfo> shaderStages;
 		VkRenderPass pass = VK_NULL_HANDLE;
 		std::vector<VkDescriptorSetLayout> setLayouts;
+		// Collected from the reflection of the added shaders
+		std::vector<VkPushConstantRange> pushConstants;
 		u32 subpass = 0;
 		const Device* device = nullptr;
 	};
@@ -98,11 +105,12 @@ namespace rv
 		Pipeline& operator= (const Pipeline&) = delete;
 		Pipeline& operator= (Pipeline&& rhs) noexcept;
 
-		static Result Create(Pipeline& pipeline, const Device& device, const PipelineLayout& layout);
+		static Result Create(Pipeline& pipeline, const Device& device, const PipelineLayout& layout, const PipelineCache* cache = nullptr);
 		static Result Create(
 			const std::vector<std::reference_wrapper<Pipeline>>& pipelines,
 			const Device& device,
-			const std::vector<std::reference_wrapper<const PipelineLayout>>& layouts
+			const std::vector<std::reference_wrapper<const PipelineLayout>>& layouts,
+			const PipelineCache* cache = nullptr
 		);
 
 		static void FillCreateInfo(VkGraphicsPipelineCreateInfo& info, const PipelineLayout& layout);
@@ -127,7 +135,7 @@ namespace rv
 
 		void Release();
 
-		static Result Create(FullPipeline& pipeline, const Device& device);
+		static Result Create(FullPipeline& pipeline, const Device& device, const PipelineCache* cache = nullptr);
 
 		Pipeline pipeline;
 		PipelineLayout layout;
@@ -0,0 +1,52 @@
+#pragma once
+#include "Engine/Graphics/Device.h"
+#include <filesystem>
+
+namespace rv
+{
+	/*
+		VkPipelineCache that is loaded from and saved to disk, one file per device and driver.
+		The file starts with a header identifying the device, the driver and the size and hash of the data,
+		a file that doesn't match any of it is ignored and overwritten on the next save.
+	*/
+	struct PipelineCache
+	{
+		PipelineCache() = default;
+		PipelineCache(const PipelineCache&) = delete;
+		PipelineCache(PipelineCache&& rhs) noexcept;
+		~PipelineCache();
+
+		PipelineCache& operator= (const PipelineCache&) = delete;
+		PipelineCache& operator= (PipelineCache&& rhs) noexcept;
+
+		// Saves the cache before destroying it
+		void Release();
+
+		static Result Create(PipelineCache& cache, const Device& device, const std::filesystem::path& directory = {});
+
+		Result Save() const;
+
+		VkPipelineCache cache = VK_NULL_HANDLE;
+		const Device* device = nullptr;
+		std::filesystem::path path;
+
+	private:
+		struct Header
+		{
+			u32 magic;
+			u32 version;
+			u32 vendorID;
+			u32 deviceID;
+			u32 driverVersion;
+			u8 uuid[VK_UUID_SIZE];
+			u64 size;
+			u64 hash;
+		};
+
+		static constexpr u32 magic = 0x43505652; // "RVPC"
+		static constexpr u32 header_version = 1;
+
+		void FillHeader(Header& header) const;
+		bool Validate(const Header& header, const std::vector<u8>& data) const;
+	};
+}
@@ -20,9 +20,11 @@ namespace rv
 		RenderPassDescriptor() = default;
 
 		u32 AddSubpass();
-		void AddColorAttachment(u32 subpass, VkFormat format, VkAttachmentLoadOp loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE, VkAttachmentStoreOp storeOp = VK_ATTACHMENT_STORE_OP_STORE);
+		void AddColorAttachment(u32 subpass, VkFormat format, VkAttachmentLoadOp loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE, VkAttachmentStoreOp storeOp = VK_ATTACHMENT_STORE_OP_STORE, VkImageLayout finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
 		void AddDependency(const VkSubpassDependency& dependency);
 		void AddColorDependency(u32 subpass = 0);
+		// Orders the color writes of the subpass before transfers that read the attachment after the pass
+		void AddTransferDependency(u32 subpass = 0);
 
 		std::vector<VkAttachmentDescription> attachments;
 		std::vector<Subpass> subpasses;
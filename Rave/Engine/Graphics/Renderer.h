@@ -1,7 +1,11 @@
 #pragma once
 #include "Engine/Graphics/Pipeline.h"
 #include "Engine/Graphics/FrameBuffer.h"
+#include "Engine/Graphics/CommandBuffer.h"
 #include "Engine/Drawable/Drawable.h"
+#include "Engine/Drawable/DrawablePool.h"
+#include "Engine/Drawable/Shape.h"
+#include "Engine/Drawable/InstancedShape.h"
 #include "Engine/Utility/Multimap.h"
 #include <set>
 
@@ -9,6 +13,11 @@ namespace rv
 {
 	class Engine;
 
+	/*
+		Records every drawable into one primary command buffer per image, which clears the image and runs
+		the drawables' secondary buffers in a single render pass. Derived renderers own the images:
+		they create the passes, the frame buffers and the draw commands, and submit them.
+	*/
 	class Renderer
 	{
 	public:
@@ -17,27 +26,114 @@ namespace rv
 		virtual ~Renderer() = default;
 
 		virtual Result Render();
+		// Blocks until none of the draw commands are in flight
+		virtual Result Wait() const;
 
 		void SetEngine(Engine& engine);
 
 		template<DrawableRendererData D>
-		D::RendererData& GetData(const D& drawable) { return drawableData.get<D::RendererData>(drawable.id()); }
+		D::RendererData& GetData(const D& drawable) { return drawableData.Get<typename D::RendererData>().get(drawable.id()); }
 		template<DrawableRendererData D>
-		D::RendererData& GetData(D drawable) { return drawableData.get<D::RendererData>(drawable.id()); }
+		D::RendererData& GetData(D drawable) { return drawableData.Get<typename D::RendererData>().get(drawable.id()); }
 		template<DrawableImageData D>
-		D::ImageData& GetImageData(const D& drawable, u32 image) { return drawableData.get<D::ImageData>(drawable.id(), image); }
+		D::ImageData& GetImageData(const D& drawable, u32 image) { return drawableData.Get<typename D::ImageData>(image).get(drawable.id()); }
 		template<DrawableImageData D>
-		D::ImageData& GetImageDataInterpreted(Drawable drawable, u32 image) { return drawableData.get<D::ImageData>(drawable.id(), image); }
+		D::ImageData& GetImageDataInterpreted(Drawable drawable, u32 image) { return drawableData.Get<typename D::ImageData>(image).get(drawable.id()); }
+		template<DrawableImageData D>
+		SparseSet<typename D::ImageData>& GetImageDataPool(u32 image) { return drawableData.Get<typename D::ImageData>(image); }
+		template<DrawableStaticImageData D>
+		D::StaticImageData& GetStaticImageData(u32 image) { return staticImageData.get<typename D::StaticImageData>(image); }
+
+		Result GetPipeline(FullPipeline*& pipeline, const PipelineLayoutDescriptor& layout);
+		Result AddPipeline(const PipelineLayoutDescriptor& layout);
+
+		Result CreateShape(Shape& shape, const HeapBuffer<Vertex2>& vertices, const HeapBuffer<u16>& indices, const FColor& color);
+		Result CreateShape(Shape& shape, HeapBuffer<Vertex2>&& vertices, HeapBuffer<u16>&& indices, const FColor& color);
+		Result CreateInstancedShape(InstancedShape& shape, ShapeMesh mesh, const Vector2& position, const Vector2& scale, const FColor& color);
+
+		template<DrawableConcept D>
+		Result AddDrawable(D& drawable);
+
+		// Records the clear and every drawable into the image's command buffer, which must not be in flight
+		Result Record(size_t index);
+		// Records the drawables of every image, spread over the engine's jobs once there is enough work. No image may be in flight.
+		Result RecordAll();
+		// Every image is recorded again right before it is rendered next, so this never waits for the frames in flight
+		void Invalidate();
+
+		u32 ImageCount() const;
+		virtual u32 CurrentImage() const;
+
+		static constexpr size_t max_recording_threads = 16;
+		// Work units of a recorder per secondary buffer, larger recorders are split over several pools
+		static constexpr u32 record_range_units = 256;
+		// Work units over all the images being recorded before the recording is spread over the engine's jobs
+		static constexpr size_t parallel_recording_threshold = 1024;
 
 	protected:
 		FullPipeline* GetCachedPipeline(const PipelineLayoutDescriptor& layout);
 		Result PrepNewPipeline(FullPipeline*& pipeline, const PipelineLayoutDescriptor& layout);
 
+		Result CreateCommandPools();
+		// Creates the clear and color pass, the color attachment ends up in finalLayout
+		Result CreatePasses(VkFormat format, VkImageLayout finalLayout);
+		// Recreates every pipeline against the current color pass in parallel
+		Result RebuildPipelines();
+		// Allocates a draw command for every frame buffer that doesn't have one yet
+		Result AllocateDrawCommands();
+		// Creates or grows the per-image data of every drawable type drawn by this renderer, the image must not be in flight
+		Result InitImageData(u32 image);
+		// Call once the image isn't in flight anymore, before it is updated and submitted. Records it again when it is stale.
+		Result PrepareImage(u32 image);
+		// Invalidates the images once shapes finished uploading, so they are recorded with them
+		Result FinishUploads();
+		void UpdateDrawables(u32 image);
+
+		// Called after the render pass of the image's primary buffer has ended
+		virtual void RecordAfterPass(const CommandBuffer& draw, size_t image) const;
+
+	private:
+		struct RecordSlot
+		{
+			size_t recorder = 0;
+			DrawableRange range;
+		};
+
+		// Splits every recorder into slots of about record_range_units each, at most one per record pool. Returns the work units of all of them.
+		size_t SplitRecorders();
+		Result AllocateSecondaries();
+		// Records every slot of the images [first, first + count)
+		Result RecordSecondaries(size_t first, size_t count);
+		Result RecordSecondary(size_t slot, size_t image);
+		Result RecordPrimary(size_t image);
+
 	protected:
 		Engine* engine = nullptr;
 		std::map<PipelineLayoutDescriptor, FullPipeline> pipelines;
 		std::set<size_t> initializedPipelines;
 
-		MultiMap drawableData;
+		DrawablePools drawableData;
+		MultiMap staticImageData;
+
+		RenderPass clearPass;
+		RenderPass colorPass;
+		Extent2D size;
+		FColor background;
+		std::vector<FrameBuffer> frameBuffers;
+		std::vector<CommandBuffer> drawCommands;
+		CommandPool drawPool;
+		/*
+			Slot s of an image is recorded into secondaryCommands[image][s], allocated from recordPools[(image + s) % recordPools.size()].
+			A pool may only be used by one thread at a time, so each recording job owns one and records its buffers of every image.
+		*/
+		std::vector<CommandPool> recordPools;
+		std::vector<std::vector<CommandBuffer>> secondaryCommands;
+		std::vector<DrawableRecorder> recorders;
+		std::vector<RecordSlot> slots;
+		std::vector<Shape::PendingUpload> pendingShapes;
+		// Images whose draw commands don't include every drawable yet
+		std::vector<bool> staleImages;
+
+		friend class GraphicsHelper;
 	};
-}
\ No newline at end of file
+}
@@ -1,5 +1,6 @@
 #pragma once
 #include "Engine/Graphics/Device.h"
+#include "Engine/Graphics/ShaderReflection.h"
 
 namespace rv
 {
@@ -44,14 +45,21 @@ namespace rv
 
 		void Release();
 
+		// Maps the SPIR-V file and creates the module straight from the mapping
 		static Result Create(Shader& shader, const Device& device, const char* filename, ShaderType type = RV_ST_NULL);
+		// RV_ST_NULL takes the type from the module's entry point
+		static Result Create(Shader& shader, const Device& device, const void* code, u64 size, ShaderType type = RV_ST_NULL);
 		static Result Compile(const char* source, const char* output);
 		static Result CompileAndCreate(Shader& shader, const Device& device, const char* source, const char* output, ShaderType type = RV_ST_NULL);
 
 		static ShaderType GetShaderTypeFromFile(const char* path);
+		// Lower case with forward slashes, Windows paths aren't case sensitive so neither are the shader names
+		static std::string NormalizeName(std::string name);
 
 		VkShaderModule shader = VK_NULL_HANDLE;
 		ShaderType type = RV_ST_NULL;
+		// Reflected once when the module is created, shaders live in a ShaderMap so this is cached per module
+		ShaderReflection reflection;
 		const Device* device = nullptr;
 
 		static const char* vulkan_path;
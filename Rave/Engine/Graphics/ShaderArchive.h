@@ -0,0 +1,72 @@
+#pragma once
+#include "Engine/Graphics/Shader.h"
+#include "Engine/Utility/MappedFile.h"
+#include <string_view>
+
+namespace rv
+{
+	/*
+		Every compiled shader in one file, built offline by the ShaderPacker.
+		The file starts with a header and a table of contents sorted by the hash of the shader names
+		(hash64 of Shader::NormalizeName, the Identifier hash on 64 bit builds), followed by the names and the SPIR-V.
+		The archive is mapped once, looking up and creating a shader needs no file system access.
+	*/
+	struct ShaderArchive
+	{
+		struct Header
+		{
+			u32 magic;
+			u32 version;
+			u32 count;
+			u32 reserved;
+		};
+
+		struct Entry
+		{
+			u64 name;			// hash64 of the normalized name
+			u64 source;			// hash64 of the GLSL source the code was compiled from
+			u64 codeOffset;
+			u64 codeSize;
+			u32 nameOffset;		// zero terminated
+			u32 nameSize;		// without the terminator
+		};
+
+		// Shader that is written to an archive
+		struct File
+		{
+			std::string name;
+			u64 source = 0;
+			std::vector<u8> code;
+		};
+
+		static constexpr u32 magic = 0x41535652; // "RVSA"
+		static constexpr u32 archive_version = 1;
+
+		ShaderArchive() = default;
+		ShaderArchive(const ShaderArchive&) = delete;
+		ShaderArchive(ShaderArchive&& rhs) noexcept;
+		~ShaderArchive();
+
+		ShaderArchive& operator= (const ShaderArchive&) = delete;
+		ShaderArchive& operator= (ShaderArchive&& rhs) noexcept;
+
+		void Release();
+
+		static Result Create(ShaderArchive& archive, const std::filesystem::path& path);
+		static Result Write(const std::filesystem::path& path, std::vector<File> files);
+
+		const Entry* Find(const char* name) const;
+		const Entry* Find(u64 name) const;
+
+		const char* Name(const Entry& entry) const;
+		const u8* Code(const Entry& entry) const;
+		Result CreateShader(Shader& shader, const Device& device, const Entry& entry) const;
+
+		static u64 HashName(const char* name);
+		static u64 HashSource(const void* source, u64 size);
+
+		MappedFile file;
+		const Entry* entries = nullptr;
+		u32 count = 0;
+	};
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include "Engine/Graphics/Vulkan.h"
+#include "Engine/Utility/Result.h"
+#include <vector>
+
+namespace rv
+{
+	/*
+		The interface a SPIR-V module declares: its stage, descriptor bindings, push constants and vertex inputs.
+		Only the declarations are parsed, the module is otherwise left to the driver and the validation layers.
+	*/
+	struct ShaderReflection
+	{
+		struct Binding
+		{
+			u32 set = 0;
+			u32 binding = 0;
+			VkDescriptorType type = VK_DESCRIPTOR_TYPE_MAX_ENUM;
+			// 0 for runtime sized arrays, the size has to be chosen when creating the layout
+			u32 count = 1;
+		};
+
+		static Result Create(ShaderReflection& reflection, const void* code, u64 size);
+
+		void Clear();
+
+		VkShaderStageFlagBits stage = VK_SHADER_STAGE_FLAG_BITS_MAX_ENUM;
+		// Sorted by set, then binding
+		std::vector<Binding> bindings;
+		// A stage has at most one push constant block, so this holds at most one range
+		std::vector<VkPushConstantRange> pushConstants;
+		// Vertex shader inputs sorted by location, tightly packed in one per-vertex buffer at binding 0
+		VkVertexInputBindingDescription vertexBinding{};
+		std::vector<VkVertexInputAttributeDescription> vertexAttributes;
+	};
+}
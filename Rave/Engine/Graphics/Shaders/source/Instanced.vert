@@ -0,0 +1,13 @@
+#version 450
+
+layout(location = 0) in vec2 inPosition;
+layout(location = 1) in vec2 inOffset;
+layout(location = 2) in vec2 inScale;
+layout(location = 3) in vec4 inColor;
+
+layout(location = 0) out vec4 fragColor;
+
+void main() {
+	gl_Position = vec4(inPosition * inScale + inOffset, 0.0, 1.0);
+	fragColor = inColor;
+}
\ No newline at end of file
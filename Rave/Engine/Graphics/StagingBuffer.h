@@ -3,29 +3,97 @@
 #include "Engine/Graphics/CommandBuffer.h"
 #include "Engine/Graphics/Fence.h"
 #include "Engine/Utility/HeapBuffer.h"
+#include <deque>
 
 namespace rv
 {
+	typedef u64 UploadToken;
+
+	/*
+		Owns one persistently mapped staging ring, an upload is a memcpy into the ring plus a recorded copy.
+		Every submission remembers where its part of the ring ends, that part is reused once its fence has signaled.
+		Uploads larger than the ring fall back to a dedicated staging buffer, recorded like any other upload
+		and kept alive by its submission until the fence has signaled.
+
+		Between BeginBatch and SubmitBatch/EndBatch uploads are only recorded, all of them into one command buffer.
+		Batches nest, only the outermost one submits. The returned token can be waited on or polled.
+	*/
 	struct StagingBufferManager
 	{
+		static constexpr u64 default_size = 16ull << 20;
+		static constexpr u64 alignment = 16;
+
 		StagingBufferManager() = default;
 		StagingBufferManager(const StagingBufferManager&) = delete;
 		StagingBufferManager(StagingBufferManager&& rhs) noexcept;
+		~StagingBufferManager();
 
 		StagingBufferManager& operator= (const StagingBufferManager&) = delete;
 		StagingBufferManager& operator= (StagingBufferManager&& rhs) noexcept;
 
 		void Release();
 
-		static Result Create(StagingBufferManager& manager, const Device& device, const MemoryAllocator& allocator, const Queue& transferQueue);
+		static Result Create(StagingBufferManager& manager, const Device& device, const MemoryAllocator& allocator, const Queue& transferQueue, u64 size = default_size);
+
+		// Submits the copy without waiting for it, or records it when a batch is open
+		Result Upload(VkBuffer destination, const void* data, u64 size, u64 dstOffset = 0);
+		Result Upload(const Buffer& destination, const void* data, u64 size, u64 dstOffset = 0);
+
+		void BeginBatch();
+		Result SubmitBatch(UploadToken& token);
+		// Submits the batch and waits for it when it is the outermost one
+		Result EndBatch();
+		bool Batching() const;
+
+		// Waits for every submitted upload
+		Result Wait();
+		Result Wait(UploadToken token);
+		bool Finished(UploadToken token);
+		// Makes the ring space of every finished upload available again
+		void Reclaim();
 
 		CommandPool pool;
-		const MemoryAllocator* allocator;
-		const Device* device;
+		const MemoryAllocator* allocator = nullptr;
+		const Device* device = nullptr;
 		Queue transferQueue;
+
+	private:
+		struct Submission
+		{
+			CommandBuffer command;
+			Fence fence;
+			u64 end = 0;
+			UploadToken token = 0;
+			std::vector<Buffer> dedicated;
+		};
+
+		Result Reserve(u64 size, u64& offset);
+		Result NextSubmission(Submission& submission);
+		Result Record(VkBuffer source, VkBuffer destination, u64 size, u64 srcOffset, u64 dstOffset);
+		Result Flush();
+		Result UploadDedicated(VkBuffer destination, const void* data, u64 size, u64 dstOffset);
+
+		Buffer ring;
+		u8* mapped = nullptr;
+		u64 capacity = 0;
+		u64 head = 0;
+		u64 tail = 0;
+		std::deque<Submission> pending;
+		std::vector<Submission> available;
+
+		Submission current;
+		bool recording = false;
+		u32 depth = 0;
+		UploadToken batch = 0;
+		UploadToken nextToken = 1;
 	};
 
-	struct StagingBuffer : public Buffer
+	/*
+		Remembers the destination of an upload so it can be repeated,
+		the data is copied into the manager's ring on every Copy.
+		Inside a batch Copy never waits, the copy completes with the batch.
+	*/
+	struct StagingBuffer
 	{
 		StagingBuffer() = default;
 		StagingBuffer(const StagingBuffer&) = delete;
@@ -37,22 +105,24 @@ namespace rv
 
 		void Release();
 
+		// Keeps size bytes of data starting at srcOffset, they are written to destination at dstOffset
 		static Result Create(
-			StagingBuffer& staging, 
-			const StagingBufferManager& manager,
-			const Buffer& destination, 
+			StagingBuffer& staging,
+			StagingBufferManager& manager,
+			const Buffer& destination,
 			const void* data,
-			u64 size, 
-			bool once,
-			u64 srcOffset = 0, 
+			u64 size,
+			u64 srcOffset = 0,
 			u64 dstOffset = 0
 		);
 
-		Result Copy() const;
-		Result Copy(const Fence& fence) const;
+		Result Copy(bool wait = true) const;
+		Result Upload(const void* source, u64 size, bool wait) const;
 
-		CommandBuffer copyCommand;
-		const StagingBufferManager* manager = nullptr;
+		StagingBufferManager* manager = nullptr;
+		VkBuffer destination = VK_NULL_HANDLE;
+		u64 dstOffset = 0;
+		std::vector<u8> bytes;
 	};
 
 	template<typename T>
@@ -63,7 +133,8 @@ namespace rv
 		MappedStagingBuffer(MappedStagingBuffer&& rhs) noexcept
 			:
 			StagingBuffer(std::move(rhs)),
-			data(std::move(rhs.data))
+			data(std::move(rhs.data)),
+			srcOffset(rhs.srcOffset)
 		{}
 		~MappedStagingBuffer()
 		{
@@ -73,8 +144,9 @@ namespace rv
 		MappedStagingBuffer& operator= (const MappedStagingBuffer&) = delete;
 		MappedStagingBuffer& operator= (MappedStagingBuffer&& rhs) noexcept
 		{
-			detail::move_buffers<StagingBuffer>(*this, rhs);
+			StagingBuffer::operator=(std::move(rhs));
 			data = std::move(rhs.data);
+			srcOffset = rhs.srcOffset;
 			return *this;
 		}
 
@@ -92,57 +164,55 @@ namespace rv
 		{
 			return (u32)data.size();
 		}
-		u64 ByteSize()
+		u64 ByteSize() const
 		{
 			return (u64)Size() * ElementSize();
 		}
 
 		static Result Create(
 			MappedStagingBuffer& staging,
-			const StagingBufferManager& manager,
+			StagingBufferManager& manager,
 			const Buffer& destination,
 			const HeapBuffer<T>& data,
-			bool once = false,
 			u64 srcOffset = 0,
 			u64 dstOffset = 0
 		)
 		{
 			staging.data = data;
-			return StagingBuffer::Create(staging, manager, destination, staging.data.data(), ByteSize(), once, srcOffset * ElementSize(), dstOffset * ElementSize());
+			return Bind(staging, manager, destination, srcOffset, dstOffset);
 		}
 		static Result Create(
 			MappedStagingBuffer& staging,
-			const StagingBufferManager& manager,
+			StagingBufferManager& manager,
 			const Buffer& destination,
 			HeapBuffer<T>&& data,
-			bool once = false,
 			u64 srcOffset = 0,
 			u64 dstOffset = 0
 		)
 		{
 			staging.data = std::move(data);
-			return StagingBuffer::Create(staging, manager, destination, staging.data.data(), ByteSize(), once, srcOffset * ElementSize(), dstOffset * ElementSize());
+			return Bind(staging, manager, destination, srcOffset, dstOffset);
 		}
 
-		Result Map() const
-		{
-			return Buffer::Map(data.data(), ByteSize());
-		}
-		Result Copy() const
-		{
-			Result result = Map();
-			if (result.failed())
-				return result;
-			return StagingBuffer::Copy();
-		}
-		Result Copy(const Fence& fence) const
+		// Uploads the current contents of data
+		Result Copy(bool wait = true) const
 		{
-			Result result = Map();
-			if (result.failed())
-				return result;
-			return StagingBuffer::Copy(fence);
+			if (srcOffset >= data.size())
+				return success;
+			return Upload(data.data() + srcOffset, ByteSize() - srcOffset * ElementSize(), wait);
 		}
 
 		HeapBuffer<T> data;
+		u64 srcOffset = 0;
+
+	private:
+		static Result Bind(MappedStagingBuffer& staging, StagingBufferManager& manager, const Buffer& destination, u64 srcOffset, u64 dstOffset)
+		{
+			staging.manager = &manager;
+			staging.destination = destination.buffer;
+			staging.srcOffset = srcOffset;
+			staging.dstOffset = dstOffset * ElementSize();
+			return success;
+		}
 	};
-}
\ No newline at end of file
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include "Engine/Graphics/Buffer.h"
+
+namespace rv
+{
+	/*
+		Persistently mapped uniform buffer split into equally sized slots, each aligned to minUniformBufferOffsetAlignment.
+		It is bound once as a dynamic uniform buffer and every draw selects its slot through a dynamic offset.
+		With another usage (e.g. per-instance vertex data) the slots are packed without padding.
+	*/
+	struct UniformArena
+	{
+		UniformArena() = default;
+		UniformArena(const UniformArena&) = delete;
+		UniformArena(UniformArena&& rhs) noexcept;
+		~UniformArena();
+
+		UniformArena& operator= (const UniformArena&) = delete;
+		UniformArena& operator= (UniformArena&& rhs) noexcept;
+
+		void Release();
+
+		static Result Create(UniformArena& arena, const Device& device, const MemoryAllocator& allocator, u64 elementSize, u32 capacity, VkBufferUsageFlags usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
+
+		template<typename T>
+		T& Get(u32 slot)
+		{
+			return *reinterpret_cast<T*>(mapped + slot * stride);
+		}
+		void Write(u32 slot, const void* data, u64 size);
+		u32 Offset(u32 slot) const;
+
+		// Makes the writes visible to the device when the memory isn't host coherent
+		void Flush() const;
+
+		Buffer buffer;
+		u8* mapped = nullptr;
+		u64 elementSize = 0;
+		u64 stride = 0;
+		u32 capacity = 0;
+	};
+}
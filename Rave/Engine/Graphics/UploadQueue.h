@@ -0,0 +1,70 @@
+#pragma once
+#include "Engine/Graphics/StagingBuffer.h"
+#include <thread>
+#include <future>
+#include <condition_variable>
+
+namespace rv
+{
+	/*
+		Streams buffer uploads from a background thread, which owns its own StagingBufferManager
+		(ring, command pool and fences). Everything queued since the last submit goes out as one batch.
+		The data is copied on Upload, the destination buffer has to stay alive until the future is ready.
+	*/
+	class UploadQueue
+	{
+	public:
+		static constexpr std::chrono::microseconds poll_interval = std::chrono::microseconds(500);
+
+		UploadQueue() = default;
+		UploadQueue(const UploadQueue&) = delete;
+		~UploadQueue();
+
+		UploadQueue& operator= (const UploadQueue&) = delete;
+
+		void Release();
+
+		static Result Create(UploadQueue& queue, const Device& device, const MemoryAllocator& allocator, const Queue& transferQueue, u64 size = StagingBufferManager::default_size);
+
+		std::future<Result> Upload(const Buffer& destination, const void* data, u64 size, u64 dstOffset = 0);
+		template<typename T>
+		std::future<Result> Upload(const Buffer& destination, const HeapBuffer<T>& data, u64 dstOffset = 0)
+		{
+			return Upload(destination, data.data(), data.size() * sizeof(T), dstOffset * sizeof(T));
+		}
+
+		// Blocks until every upload queued so far has completed
+		void Wait();
+		size_t Outstanding() const;
+
+	private:
+		struct Request
+		{
+			VkBuffer destination = VK_NULL_HANDLE;
+			std::vector<u8> data;
+			u64 dstOffset = 0;
+			std::promise<Result> promise;
+		};
+
+		struct Batch
+		{
+			UploadToken token = 0;
+			std::vector<std::promise<Result>> promises;
+		};
+
+		void Run(const Device& device, const MemoryAllocator& allocator, const Queue& transferQueue, u64 size, std::promise<Result> created);
+		void Submit(std::vector<Request>& requests);
+		void Complete(size_t count);
+
+		StagingBufferManager manager;
+		std::deque<Batch> batches;
+
+		std::thread worker;
+		mutable std::mutex mutex;
+		std::condition_variable condition;
+		std::condition_variable idle;
+		std::vector<Request> requests;
+		size_t outstanding = 0;
+		bool running = false;
+	};
+}
@@ -1,5 +1,6 @@
 #pragma once
 #include "Engine/Graphics/Vulkan.h"
+#include "Engine/Graphics/ShaderReflection.h"
 #include "Engine/Utility/Vector.h"
 #include <array>
 
@@ -115,9 +116,13 @@ namespace rv
 	template<typename T, T... Args>
 	concept ArgsNotEmpty = sizeof...(Args) != 0;
 
-	template<VkFormat... Formats>
+	/*
+		Describes one vertex buffer binding, the attributes get consecutive locations starting at FirstLocation.
+		Per-instance data lives in its own binding so it can be combined with an existing vertex type.
+	*/
+	template<u32 Binding, VkVertexInputRate Rate, u32 FirstLocation, VkFormat... Formats>
 	requires ArgsNotEmpty<VkFormat, Formats...>
-	struct Vertex
+	struct VertexInput
 	{
 	public:
 		static constexpr size_t size() { return sizeof...(Formats); }
@@ -135,21 +140,21 @@ namespace rv
 		static constexpr VkVertexInputBindingDescription GetBinding()
 		{
 			VkVertexInputBindingDescription bindingDescription{};
-			bindingDescription.binding = 0;
+			bindingDescription.binding = Binding;
 			bindingDescription.stride = GetStride<0, Formats...>();
-			bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+			bindingDescription.inputRate = Rate;
 			return bindingDescription;
 		}
 
 		template<size_t D, VkFormat F, VkFormat... Args>
 		static constexpr void SetAttribute(std::array<VkVertexInputAttributeDescription, size()>& attributes, u32& location, u32& offset)
 		{
-			attributes[D].binding = 0;
+			attributes[D].binding = Binding;
 			attributes[D].location = location;
 			attributes[D].format = F;
 			attributes[D].offset = offset;
 			offset += detail::GetFormatSize(F);
-			location += detail::GetFormatSize(F) / 4;
+			location += (detail::GetFormatSize(F) + 15) / 16;
 			if constexpr (D < size() - 1)
 				SetAttribute<D + 1, Args...>(attributes, location, offset);
 		}
@@ -157,7 +162,7 @@ namespace rv
 		static constexpr std::array<VkVertexInputAttributeDescription, size()> GetAttributes()
 		{
 			std::array<VkVertexInputAttributeDescription, size()> attributes {};
-			u32 location = 0;
+			u32 location = FirstLocation;
 			u32 offset = 0;
 			SetAttribute<0, Formats...>(attributes, location, offset);
 			return attributes;
@@ -168,6 +173,13 @@ namespace rv
 		static constexpr std::array<VkVertexInputAttributeDescription, size()> attributes = GetAttributes();
 	};
 
+	template<VkFormat... Formats>
+	using Vertex = VertexInput<0, VK_VERTEX_INPUT_RATE_VERTEX, 0, Formats...>;
+
+	// FirstLocation has to come after the locations used by the per-vertex type it is paired with
+	template<u32 FirstLocation, VkFormat... Formats>
+	using InstanceVertex = VertexInput<1, VK_VERTEX_INPUT_RATE_INSTANCE, FirstLocation, Formats...>;
+
 	template<typename V>
 	concept VertexConcept = requires (V vertex)
 	{
@@ -190,10 +202,28 @@ namespace rv
 			attributes = V::attributes.data();
 			nAttributes = V::attributes.size();
 		}
+		template<VertexConcept V, VertexConcept I>
+		void Set()
+		{
+			Set<V>();
+			instanceBinding = &I::binding;
+			instanceAttributes = I::attributes.data();
+			nInstanceAttributes = I::attributes.size();
+		}
+		// Points into the reflection, which has to outlive the descriptor and the pipelines made from it
+		void Set(const ShaderReflection& vertexShader)
+		{
+			binding = &vertexShader.vertexBinding;
+			attributes = vertexShader.vertexAttributes.data();
+			nAttributes = vertexShader.vertexAttributes.size();
+		}
 
 		const VkVertexInputBindingDescription* binding = nullptr;
 		const VkVertexInputAttributeDescription* attributes = nullptr;
 		size_t nAttributes = 0;
+		const VkVertexInputBindingDescription* instanceBinding = nullptr;
+		const VkVertexInputAttributeDescription* instanceAttributes = nullptr;
+		size_t nInstanceAttributes = 0;
 	};
 
 	struct Vertex2 : public Vertex<VK_FORMAT_R32G32_SFLOAT>
@@ -64,20 +64,21 @@ rv::Result rv::Buffer::Create(Buffer& buffer, const MemoryAllocator& allocator,
 	return success;
 }
 
-rv::Result rv::Buffer::Create(Buffer& buffer, const StagingBufferManager& manager, const void* data, u64 size, VkBufferUsageFlags bufferUsage, VmaMemoryUsage memoryUsage)
+rv::Result rv::Buffer::Create(Buffer& buffer, StagingBufferManager& manager, const void* data, u64 size, VkBufferUsageFlags bufferUsage, VmaMemoryUsage memoryUsage)
 {
 	rv_result;
 	rv_rif(Create(buffer, *manager.allocator, size, bufferUsage | VK_BUFFER_USAGE_TRANSFER_DST_BIT, memoryUsage));
-	StagingBuffer staging;
-	rv_rif(StagingBuffer::Create(staging, manager, buffer, data, size, true));
-	return staging.Copy();
+	rv_rif(manager.Upload(buffer, data, size));
+	if (manager.Batching())
+		return result;
+	return manager.Wait();
 }
 
-rv::Result rv::Buffer::Create(Buffer& buffer, StagingBuffer& staging, const StagingBufferManager& manager, const void* data, u64 size, VkBufferUsageFlags bufferUsage, VmaMemoryUsage memoryUsage)
+rv::Result rv::Buffer::Create(Buffer& buffer, StagingBuffer& staging, StagingBufferManager& manager, const void* data, u64 size, VkBufferUsageFlags bufferUsage, VmaMemoryUsage memoryUsage)
 {
 	rv_result;
 	rv_rif(Create(buffer, *manager.allocator, size, bufferUsage | VK_BUFFER_USAGE_TRANSFER_DST_BIT, memoryUsage));
-	rv_rif(StagingBuffer::Create(staging, manager, buffer, data, size, false));
+	rv_rif(StagingBuffer::Create(staging, manager, buffer, data, size));
 	return staging.Copy();
 }
 
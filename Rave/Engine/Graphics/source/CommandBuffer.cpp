@@ -1,5 +1,6 @@
 #include "Engine/Graphics/CommandBuffer.h"
 #include "Engine/Utility/Error.h"
+#include <algorithm>
 
 template<>
 void rv::destroy(VkCommandBuffer buffer, VkDevice device, VkInstance)
@@ -31,7 +32,7 @@ void rv::CommandBuffer::Release()
 		release(buffer, *device);
 }
 
-rv::Result rv::CommandBuffer::Create(CommandBuffer& buffer, const Device& device, const CommandPool& pool)
+rv::Result rv::CommandBuffer::Create(CommandBuffer& buffer, const Device& device, const CommandPool& pool, VkCommandBufferLevel level)
 {
 	buffer.Release();
 
@@ -39,12 +40,12 @@ rv::Result rv::CommandBuffer::Create(CommandBuffer& buffer, const Device& device
 	VkCommandBufferAllocateInfo allocInfo{};
 	allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
 	allocInfo.commandPool = pool.pool;
-	allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	allocInfo.level = level;
 	allocInfo.commandBufferCount = 1;
 	return rv_try_vkr(vkAllocateCommandBuffers(device.device, &allocInfo, &buffer.buffer));
 }
 
-rv::Result rv::CommandBuffer::Create(std::vector<std::reference_wrapper<CommandBuffer>> buffers, const Device& device, const CommandPool& pool)
+rv::Result rv::CommandBuffer::Create(std::vector<std::reference_wrapper<CommandBuffer>> buffers, const Device& device, const CommandPool& pool, VkCommandBufferLevel level)
 {
 	for (auto& buffer : buffers)
 		buffer.get().Release();
@@ -54,7 +55,7 @@ rv::Result rv::CommandBuffer::Create(std::vector<std::reference_wrapper<CommandB
 	VkCommandBufferAllocateInfo allocInfo{};
 	allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
 	allocInfo.commandPool = pool.pool;
-	allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	allocInfo.level = level;
 	allocInfo.commandBufferCount = (u32)buffers.size();
 
 	Result result = rv_try_vkr(vkAllocateCommandBuffers(device.device, &allocInfo, cmd.data()));
@@ -79,12 +80,27 @@ rv::Result rv::CommandBuffer::Begin(bool once) const
 	return rv_try_vkr(vkBeginCommandBuffer(buffer, &beginInfo));
 }
 
+rv::Result rv::CommandBuffer::Begin(const RenderPass& pass, const FrameBuffer& frame, u32 subpass) const
+{
+	VkCommandBufferInheritanceInfo inheritance{};
+	inheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+	inheritance.renderPass = pass.pass;
+	inheritance.subpass = subpass;
+	inheritance.framebuffer = frame.frame;
+
+	VkCommandBufferBeginInfo beginInfo{};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+	beginInfo.pInheritanceInfo = &inheritance;
+	return rv_try_vkr(vkBeginCommandBuffer(buffer, &beginInfo));
+}
+
 rv::Result rv::CommandBuffer::End() const
 {
 	return rv_try_vkr(vkEndCommandBuffer(buffer));
 }
 
-void rv::CommandBuffer::StartRenderPass(const RenderPass& pass, const FrameBuffer& frame, const Point& offset, const Extent2D& size, const FColor& color) const
+void rv::CommandBuffer::StartRenderPass(const RenderPass& pass, const FrameBuffer& frame, const Point& offset, const Extent2D& size, const FColor& color, VkSubpassContents contents) const
 {
 	VkRenderPassBeginInfo renderPassInfo{};
 	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
@@ -96,7 +112,7 @@ void rv::CommandBuffer::StartRenderPass(const RenderPass& pass, const FrameBuffe
 	clearColor.color = { { color.r, color.g, color.b, color.a } };
 	renderPassInfo.clearValueCount = 1;
 	renderPassInfo.pClearValues = &clearColor;
-	vkCmdBeginRenderPass(buffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+	vkCmdBeginRenderPass(buffer, &renderPassInfo, contents);
 }
 
 void rv::CommandBuffer::EndRenderPass() const
@@ -104,6 +120,32 @@ void rv::CommandBuffer::EndRenderPass() const
 	vkCmdEndRenderPass(buffer);
 }
 
+void rv::CommandBuffer::SetViewport(const Extent2D& size) const
+{
+	VkViewport viewport{};
+	viewport.width = (float)size.width;
+	viewport.height = (float)size.height;
+	viewport.maxDepth = 1.0f;
+	VkRect2D scissor{};
+	scissor.extent = { size.width, size.height };
+	vkCmdSetViewport(buffer, 0, 1, &viewport);
+	vkCmdSetScissor(buffer, 0, 1, &scissor);
+}
+
+void rv::CommandBuffer::ExecuteCommands(const std::vector<CommandBuffer>& buffers) const
+{
+	ExecuteCommands(buffers.data(), (u32)buffers.size());
+}
+
+void rv::CommandBuffer::ExecuteCommands(const CommandBuffer* buffers, u32 count) const
+{
+	if (count == 0)
+		return;
+	std::vector<VkCommandBuffer> commands(count);
+	std::transform(buffers, buffers + count, commands.begin(), [](const CommandBuffer& command) { return command.buffer; });
+	vkCmdExecuteCommands(buffer, count, commands.data());
+}
+
 void rv::CommandBuffer::BindPipeline(const Pipeline& pipeline) const
 {
 	vkCmdBindPipeline(buffer, (VkPipelineBindPoint)pipeline.type, pipeline.pipeline);
@@ -115,6 +157,11 @@ void rv::CommandBuffer::BindVertexBuffer(const VertexBuffer& vertices) const
 	vkCmdBindVertexBuffers(buffer, 0, 1, &vertices.buffer, &offset);
 }
 
+void rv::CommandBuffer::BindVertexBuffer(const Buffer& vertices, u32 binding, u64 offset) const
+{
+	vkCmdBindVertexBuffers(buffer, binding, 1, &vertices.buffer, &offset);
+}
+
 void rv::CommandBuffer::BindIndexBuffer(const IndexBuffer& indices) const
 {
 	vkCmdBindIndexBuffer(buffer, indices.buffer, 0, indices.type);
@@ -125,6 +172,11 @@ void rv::CommandBuffer::BindDescriptorSet(const DescriptorSet& set, const Pipeli
 	vkCmdBindDescriptorSets(buffer, (VkPipelineBindPoint)type, layout.layout, 0, 1, &set.set, 0, nullptr);
 }
 
+void rv::CommandBuffer::BindDescriptorSet(const DescriptorSet& set, const PipelineLayout& layout, u32 dynamicOffset, PipelineType type)
+{
+	vkCmdBindDescriptorSets(buffer, (VkPipelineBindPoint)type, layout.layout, 0, 1, &set.set, 1, &dynamicOffset);
+}
+
 void rv::CommandBuffer::Draw(u32 nVertices, u32 nInstances, u32 vertexOffset, u32 instanceOffset) const
 {
 	vkCmdDraw(buffer, nVertices, nInstances, vertexOffset, instanceOffset);
@@ -144,6 +196,35 @@ void rv::CommandBuffer::CopyBuffers(const Buffer& source, const Buffer& dest, u6
 	vkCmdCopyBuffer(buffer, source.buffer, dest.buffer, 1, &copyRegion);
 }
 
+void rv::CommandBuffer::CopyImageToBuffer(const Image& source, const Buffer& dest) const
+{
+	VkBufferImageCopy region{};
+	region.bufferOffset = 0;
+	region.bufferRowLength = 0;
+	region.bufferImageHeight = 0;
+	region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	region.imageSubresource.mipLevel = 0;
+	region.imageSubresource.baseArrayLayer = 0;
+	region.imageSubresource.layerCount = 1;
+	region.imageOffset = { 0, 0, 0 };
+	region.imageExtent = { source.size.width, source.size.height, 1 };
+	vkCmdCopyImageToBuffer(buffer, source.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, dest.buffer, 1, &region);
+}
+
+void rv::CommandBuffer::HostReadBarrier(const Buffer& dest) const
+{
+	VkBufferMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.buffer = dest.buffer;
+	barrier.offset = 0;
+	barrier.size = VK_WHOLE_SIZE;
+	vkCmdPipelineBarrier(buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+}
+
 rv::Result rv::CommandBuffer::Submit(const Fence* fence) const
 {
 	return Submit(device->graphicsQueue, fence);
@@ -155,6 +236,7 @@ rv::Result rv::CommandBuffer::Submit(const Queue& queue, const Fence* fence) con
 	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 	submitInfo.commandBufferCount = 1;
 	submitInfo.pCommandBuffers = &buffer;
+	auto lock = queue.Lock();
 	return rv_try_vkr(vkQueueSubmit(queue.queue, 1, &submitInfo, fence ? fence->fence : VK_NULL_HANDLE));
 }
 
@@ -174,6 +256,7 @@ rv::Result rv::CommandBuffer::Submit(const Queue& queue, const std::vector<VkSem
 	submitInfo.pWaitSemaphores = waitSemaphores.data();
 	submitInfo.pWaitDstStageMask = waitStages.data();
 
+	auto lock = queue.Lock();
 	return rv_try_vkr(vkQueueSubmit(queue.queue, 1, &submitInfo, fence ? fence->fence : VK_NULL_HANDLE));
 }
 
@@ -189,6 +272,7 @@ rv::Result rv::CommandBuffer::Submit(const Queue& queue, const Semaphore& waitSe
 	submitInfo.pWaitSemaphores = &waitSemaphore.semaphore;
 	submitInfo.pWaitDstStageMask = &waitStage;
 
+	auto lock = queue.Lock();
 	return rv_try_vkr(vkQueueSubmit(queue.queue, 1, &submitInfo, fence ? fence->fence : VK_NULL_HANDLE));
 }
 
@@ -215,6 +299,7 @@ rv::Result rv::CommandBuffer::Submit(const SubmitInfo& submitInfo, const Queue&
 	VkSubmitInfo vkSubmitInfo{};
 	submitInfo.Fill(vkSubmitInfo);
 
+	auto lock = queue.Lock();
 	return rv_try_vkr(vkQueueSubmit(queue.queue, 1, &vkSubmitInfo, fence ? fence->fence : VK_NULL_HANDLE));
 }
 
@@ -229,6 +314,7 @@ rv::Result rv::CommandBuffer::Submit(const std::vector<SubmitInfo>& submitInfos,
 		rif_assert(submitInfos[i].waitSemaphores.size() == submitInfos[i].waitStages.size());
 		submitInfos[i].Fill(submitInfo[i]);
 	}
+	auto lock = queue.Lock();
 	return rv_try_vkr(vkQueueSubmit(queue.queue, (u32)submitInfo.size(), submitInfo.data(), fence ? fence->fence : VK_NULL_HANDLE));
 }
 
@@ -1,5 +1,7 @@
 #include "Engine/Graphics/DescriptorSet.h"
 #include "Engine/Utility/Error.h"
+#include "Engine/Utility/Hash.h"
+#include <algorithm>
 
 template<>
 void rv::destroy(VkDescriptorSetLayout layout, VkDevice device, VkInstance)
@@ -23,6 +25,41 @@ void rv::DescriptorSetBindings::AddBinding(Flags<ShaderType, u32> shaderTypes, V
 	bindings.push_back(binding);
 }
 
+rv::Result rv::DescriptorSetBindings::AddShader(const Shader& shader, u32 set, bool dynamic)
+{
+	rv_result;
+	for (const auto& reflected : shader.reflection.bindings)
+	{
+		if (reflected.set != set)
+			continue;
+
+		VkDescriptorType type = reflected.type;
+		if (dynamic && type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER)
+			type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+		else if (dynamic && type == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER)
+			type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+
+		// Kept sorted by binding, so sets built from the same shaders compare equal
+		auto it = std::lower_bound(bindings.begin(), bindings.end(), reflected.binding, [](const VkDescriptorSetLayoutBinding& binding, u32 index) {
+			return binding.binding < index;
+		});
+		if (it != bindings.end() && it->binding == reflected.binding)
+		{
+			rif_check_info(it->descriptorType == type && it->descriptorCount == reflected.count, "Shader stages disagree on a descriptor binding");
+			it->stageFlags |= shader.reflection.stage;
+			continue;
+		}
+
+		VkDescriptorSetLayoutBinding binding{};
+		binding.binding = reflected.binding;
+		binding.descriptorCount = reflected.count;
+		binding.descriptorType = type;
+		binding.stageFlags = shader.reflection.stage;
+		bindings.insert(it, binding);
+	}
+	return result;
+}
+
 int rv::DescriptorSetBindings::operator<=>(const DescriptorSetBindings& rhs) const
 {
 	if (bindings.size() < rhs.bindings.size())
@@ -33,6 +70,16 @@ int rv::DescriptorSetBindings::operator<=>(const DescriptorSetBindings& rhs) con
 		return memcmp(bindings.data(), rhs.bindings.data(), bindings.size() * sizeof(VkDescriptorSetLayoutBinding));
 }
 
+bool rv::DescriptorSetBindings::operator==(const DescriptorSetBindings& rhs) const
+{
+	return (*this <=> rhs) == 0;
+}
+
+size_t rv::DescriptorSetBindings::Hash() const
+{
+	return detail::fnv1a<size_t>(reinterpret_cast<const byte*>(bindings.data()), bindings.size() * sizeof(VkDescriptorSetLayoutBinding));
+}
+
 rv::DescriptorSetLayout::DescriptorSetLayout(DescriptorSetLayout&& rhs) noexcept
 	:
 	layout(move(rhs.layout)),
@@ -96,7 +143,7 @@ rv::DescriptorPool& rv::DescriptorPool::operator=(DescriptorPool&& rhs) noexcept
 	return *this;
 }
 
-rv::Result rv::DescriptorPool::Create(DescriptorPool& pool, const Device& device, const DescriptorPoolSizes& sizes)
+rv::Result rv::DescriptorPool::Create(DescriptorPool& pool, const Device& device, const DescriptorPoolSizes& sizes, u32 maxSets)
 {
 	pool.Release();
 	pool.device = &device;
@@ -117,7 +164,7 @@ rv::Result rv::DescriptorPool::Create(DescriptorPool& pool, const Device& device
 	createInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
 	createInfo.poolSizeCount = (u32)poolSizes.size();
 	createInfo.pPoolSizes = poolSizes.data();
-	createInfo.maxSets = maxSize;
+	createInfo.maxSets = maxSets ? maxSets : maxSize;
 
 	return rv_try_vkr(vkCreateDescriptorPool(device.device, &createInfo, nullptr, &pool.pool));
 }
@@ -213,6 +260,7 @@ rv::Result rv::DescriptorPool::Free(std::vector<std::reference_wrapper<Descripto
 		if (std::all_of(sets.begin(), sets.end(), [](const DescriptorSet& set) { return set.set; }))
 		{
 			std::vector<VkDescriptorSet> dsets(sets.size());
+			std::transform(sets.begin(), sets.end(), dsets.begin(), [](const DescriptorSet& set) { return set.set; });
 			result = rv_try_vkr(vkFreeDescriptorSets(device->device, pool, (u32)sets.size(), dsets.data()));
 
 			for (DescriptorSet& set : sets)
@@ -228,6 +276,11 @@ rv::Result rv::DescriptorPool::Free(std::vector<std::reference_wrapper<Descripto
 	return result;
 }
 
+rv::Result rv::DescriptorPool::Reset()
+{
+	return rv_try_vkr(vkResetDescriptorPool(device->device, pool, 0));
+}
+
 void rv::DescriptorPool::Release()
 {
 	if (device)
@@ -274,13 +327,13 @@ void rv::DescriptorSet::Release()
 	device = nullptr;
 }
 
-rv::DescriptorSetAllocator::DescriptorSetAllocator(Device& device)
+rv::DescriptorSetAllocator::DescriptorSetAllocator(const Device& device)
 	:
 	device(&device)
 {
 }
 
-void rv::DescriptorSetAllocator::SetDevice(Device& device)
+void rv::DescriptorSetAllocator::SetDevice(const Device& device)
 {
 	this->device = &device;
 }
@@ -290,8 +343,8 @@ rv::Result rv::DescriptorSetAllocator::GetQueue(Queue*& queue, const DescriptorS
 	rv_result;
 	rif_assert(device);
 
-	auto it = queues.find(bindings);
-	if (it != queues.end())
+	auto [it, created] = queues.try_emplace(bindings);
+	if (!created)
 	{
 		queue = &it->second;
 		return success;
@@ -299,11 +352,13 @@ rv::Result rv::DescriptorSetAllocator::GetQueue(Queue*& queue, const DescriptorS
 
 	queue = nullptr;
 
-	auto& q = queues[bindings];
+	auto& q = it->second;
 	rv_rif(DescriptorSetLayout::Create(q.layout, *device, bindings));
 
+	// Runtime sized arrays have no count yet and pool sizes can't be 0
 	for (const auto& binding : bindings.bindings)
-		q.entrySizes.AddSize(binding.descriptorType, binding.descriptorCount);
+		if (binding.descriptorCount)
+			q.entrySizes.AddSize(binding.descriptorType, binding.descriptorCount);
 
 	queue = &q;
 	return result;
@@ -323,36 +378,133 @@ rv::Result rv::DescriptorSetAllocator::Allocate(DescriptorSet& set, Queue& queue
 	rv_result;
 	rif_assert(device);
 
-	DescriptorPool* pool = nullptr;
-	rv_rif(queue.NextPool(pool, *device));
-	rif_assert(pool);
+	Free(set, queue);
+	// A failed allocation may have put the handle it wrote back on the free list, the set only takes it on success
+	VkDescriptorSet dset = VK_NULL_HANDLE;
+	rv_rif(queue.Allocate(&dset, 1, *device));
+	set.set = dset;
+	set.device = device;
+	return result;
+}
+
+rv::Result rv::DescriptorSetAllocator::Allocate(std::vector<std::reference_wrapper<DescriptorSet>>& sets, Queue& queue)
+{
+	rv_result;
+	rif_assert(device);
+
+	for (DescriptorSet& set : sets)
+		Free(set, queue);
+
+	std::vector<VkDescriptorSet> dsets(sets.size());
+	rv_rif(queue.Allocate(dsets.data(), (u32)dsets.size(), *device));
 
-	return pool->Allocate(set, queue.layout);
+	for (size_t i = 0; i < sets.size(); ++i)
+	{
+		sets[i].get().set = dsets[i];
+		sets[i].get().device = device;
+	}
+	return result;
+}
+
+void rv::DescriptorSetAllocator::Free(DescriptorSet& set, Queue& queue)
+{
+	if (set.set)
+		queue.Free(set.set);
+	set.Release();
+}
+
+rv::Result rv::DescriptorSetAllocator::Reset()
+{
+	rv_result;
+	for (auto& [bindings, queue] : queues)
+		rv_rif(queue.Reset());
+	return result;
+}
+
+rv::Result rv::DescriptorSetAllocator::Queue::Allocate(VkDescriptorSet* sets, u32 count, const Device& device)
+{
+	VkDescriptorSet* const first = sets;
+	const u32 reused = std::min(count, (u32)free.size());
+	std::copy(free.end() - reused, free.end(), sets);
+	free.resize(free.size() - reused);
+	sets += reused;
+	count -= reused;
+
+	// Nothing is handed out on failure, the reused sets and the ones allocated so far go back on the free list
+	Result result = AllocateFromPools(sets, count, device);
+	if (result.failed())
+		free.insert(free.end(), first, sets);
+	return result;
 }
 
-rv::Result rv::DescriptorSetAllocator::Queue::NextPool(DescriptorPool*& pool, Device& device)
+rv::Result rv::DescriptorSetAllocator::Queue::AllocateFromPools(VkDescriptorSet*& sets, u32& count, const Device& device)
 {
 	rv_result;
-	pool = nullptr;
-	if (!entries.empty())
+	while (count)
 	{
-		Entry& entry = entries.back();
-		if (entry.used < entry.max)
+		if (current == entries.size())
+			rv_rif(NextPool(device));
+
+		Entry& entry = entries[current];
+		const u32 n = std::min(count, entry.max - entry.used);
+		if (layouts.size() < n)
+			layouts.resize(n, layout.layout);
+
+		VkDescriptorSetAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocInfo.descriptorPool = entry.pool.pool;
+		allocInfo.descriptorSetCount = n;
+		allocInfo.pSetLayouts = layouts.data();
+
+		const VkResult vkr = vkAllocateDescriptorSets(device.device, &allocInfo, sets);
+		if ((vkr == VK_ERROR_OUT_OF_POOL_MEMORY || vkr == VK_ERROR_FRAGMENTED_POOL) && entry.used != 0)
 		{
-			entry.used++;
-			pool = &entry.pool;
-			return result;
+			// The pool is sized for max sets, but the driver has the final say
+			entry.used = entry.max;
+			++current;
+			continue;
 		}
+		rif_try_vkr(vkr);
+
+		entry.used += n;
+		if (entry.used == entry.max)
+			++current;
+		sets += n;
+		count -= n;
 	}
+	return result;
+}
+
+void rv::DescriptorSetAllocator::Queue::Free(VkDescriptorSet set)
+{
+	free.push_back(set);
+}
+
+rv::Result rv::DescriptorSetAllocator::Queue::Reset()
+{
+	rv_result;
+	for (auto& entry : entries)
+	{
+		if (entry.used)
+			rv_rif(entry.pool.Reset());
+		entry.used = 0;
+	}
+	free.clear();
+	current = 0;
+	return result;
+}
 
+rv::Result rv::DescriptorSetAllocator::Queue::NextPool(const Device& device)
+{
+	rv_result;
 	Entry entry;
 	entry.max = size;
-	size *= 2;
+	size = std::min(size * 2, max_pool_sets);
+
 	DescriptorPoolSizes sizes = entrySizes;
-	for (auto& [type, size] : sizes.sizes)
-		size *= entry.max;
-	rv_rif(DescriptorPool::Create(entry.pool, device, entrySizes));
-	entries.push(std::move(entry));
-	pool = &entries.back().pool;
+	for (auto& [type, count] : sizes.sizes)
+		count *= entry.max;
+	rv_rif(DescriptorPool::Create(entry.pool, device, sizes, entry.max));
+	entries.push_back(std::move(entry));
 	return result;
-}
\ No newline at end of file
+}
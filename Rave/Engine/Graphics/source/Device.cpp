@@ -17,7 +17,8 @@ rv::Device::Device(Device&& rhs) noexcept
 	physical(std::move(rhs.physical)),
 	graphicsQueue(std::move(rhs.graphicsQueue)),
 	computeQueue(std::move(rhs.computeQueue)),
-	extensions(std::move(rhs.extensions))
+	extensions(std::move(rhs.extensions)),
+	queueMutexes(std::move(rhs.queueMutexes))
 {
 }
 
@@ -33,6 +34,7 @@ rv::Device& rv::Device::operator=(Device&& rhs) noexcept
 	graphicsQueue = std::move(rhs.graphicsQueue);
 	computeQueue = std::move(rhs.computeQueue);
 	extensions = std::move(rhs.extensions);
+	queueMutexes = std::move(rhs.queueMutexes);
 	return *this;
 }
 
@@ -44,6 +46,7 @@ void rv::Device::Release()
 	graphicsQueue.Release();
 	computeQueue.Release();
 	extensions.extensions.clear();
+	queueMutexes.clear();
 }
 
 rv::Result rv::Device::Create(
@@ -125,6 +128,7 @@ rv::Queue rv::Device::GetQueue(u32 family, u32 index) const
 	vkGetDeviceQueue(device, family, index, &queue.queue);
 	queue.family = family;
 	queue.index = index;
+	queue.mutex = QueueMutex(queue.queue);
 	return queue;
 }
 
@@ -137,15 +141,31 @@ rv::Queue rv::Device::GetQueue(const QueueFamilyGetter& family, u32 index) const
 		vkGetDeviceQueue(device, f.value, index, &queue.queue);
 		queue.family = f.value;
 		queue.index = index;
+		queue.mutex = QueueMutex(queue.queue);
 	}
 	return queue;
 }
 
 rv::Result rv::Device::Wait() const
 {
-	if (device)
-		return rv_try_vkr(vkDeviceWaitIdle(device));
-	return success;
+	if (!device)
+		return success;
+
+	std::vector<std::unique_lock<std::mutex>> locks;
+	locks.reserve(queueMutexes.size());
+	for (const auto& [queue, mutex] : queueMutexes)
+		locks.emplace_back(*mutex);
+	return rv_try_vkr(vkDeviceWaitIdle(device));
+}
+
+std::mutex* rv::Device::QueueMutex(VkQueue queue) const
+{
+	if (!queue)
+		return nullptr;
+	auto& mutex = queueMutexes[queue];
+	if (!mutex)
+		mutex = std::make_unique<std::mutex>();
+	return mutex.get();
 }
 
 rv::Result rv::PhysicalDevice::Create(
@@ -332,7 +352,8 @@ rv::Queue::Queue(Queue&& rhs) noexcept
 	:
 	queue(std::move(rhs.queue)),
 	family(rhs.family),
-	index(rhs.index)
+	index(rhs.index),
+	mutex(move(rhs.mutex))
 {
 	rhs.family = 0;
 	rhs.index = 0;
@@ -343,6 +364,7 @@ rv::Queue& rv::Queue::operator=(Queue&& rhs) noexcept
 	queue = move(rhs.queue);
 	family = rhs.family;
 	index = rhs.index;
+	mutex = move(rhs.mutex);
 	rhs.family = 0;
 	rhs.index = 0;
 	return *this;
@@ -353,13 +375,22 @@ void rv::Queue::Release()
 	queue = VK_NULL_HANDLE;
 	family = 0;
 	index = 0;
+	mutex = nullptr;
 }
 
 rv::Result rv::Queue::Wait() const
 {
-	if (queue)
-		return rv_try_vkr(vkQueueWaitIdle(queue));
-	return success;
+	if (!queue)
+		return success;
+	auto lock = Lock();
+	return rv_try_vkr(vkQueueWaitIdle(queue));
+}
+
+std::unique_lock<std::mutex> rv::Queue::Lock() const
+{
+	if (mutex)
+		return std::unique_lock<std::mutex>(*mutex);
+	return {};
 }
 
 void rv::DeviceRater::AddTypeMultiplier(VkPhysicalDeviceType type, int multiplier)
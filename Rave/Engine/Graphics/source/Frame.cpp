@@ -1,5 +1,6 @@
 #include "Engine/Graphics/Frame.h"
 #include "Engine/Utility/Error.h"
+#include "Engine/Utility/PerformanceLogger.h"
 
 rv::Frame::Frame(SwapChain& swap)
 	:
@@ -14,6 +15,7 @@ void rv::Frame::SetSwapChain(SwapChain& s)
 
 rv::Result rv::Frame::Start(u32& image, bool& resized)
 {
+	rv_performance_scope("Frame::Start");
 	rv_result;
 	rif_assert(swap);
 
@@ -29,32 +31,18 @@ rv::Result rv::Frame::Start(u32& image, bool& resized)
 
 	swap->imagesInFlight[image] = inFlight.fence;
 
-	{
-		rv_result;
-		rif_assert(!first);
-		first = true;
-	}
-
 	return result;
 }
 
 rv::Result rv::Frame::Render(const CommandBuffer& drawCommand)
-{
-	Result result = drawCommand.Submit(drawCommand.device->graphicsQueue, first ? imageAvailable : renderFinished, renderFinished, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
-	first = false;
-	return result;
-}
-
-rv::Result rv::Frame::RenderLast(const CommandBuffer& drawCommand)
 {
 	inFlight.Reset();
-	Result result = drawCommand.Submit(drawCommand.device->graphicsQueue, first ? imageAvailable : renderFinished, renderFinished, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, &inFlight);
-	first = false;
-	return result;
+	return drawCommand.Submit(drawCommand.device->graphicsQueue, imageAvailable, renderFinished, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, &inFlight);
 }
 
 rv::Result rv::Frame::End(bool& resized)
 {
+	rv_performance_scope("Frame::End");
 	return swap->Present(image, renderFinished, resized);
 }
 
@@ -4,6 +4,7 @@
 #include "Engine/Utility/File.h"
 #include "Engine/Core/Logger.h"
 #include <algorithm>
+#include <cstring>
 
 #ifdef RV_DEBUG
 #	define check_debug()		rv_rif(debug.Check())
@@ -33,11 +34,23 @@ rv::GraphicsInfo::GraphicsInfo(const std::vector<std::reference_wrapper<const Wi
 {
 }
 
-rv::Result rv::Graphics::Create(Graphics& graphics, const GraphicsInfo& info)
+rv::Result rv::Graphics::Create(Graphics& graphics, const GraphicsInfo& info, JobSystem* jobs)
 {
 	rv_result;
+	graphics.jobs = jobs;
 
-	rv_rif(Instance::Create(graphics.instance, info.app));
+	if (info.headless)
+	{
+		rif_check_info(info.surfaces.empty() && info.windows.empty(), "A headless Graphics can't present to surfaces");
+		Extensions extensions = std::vector<const char*>{};
+		if constexpr (cti.build.debug)
+			extensions.AddExtension(RV_EXTENSION_DEBUG);
+		rv_rif(Instance::Create(graphics.instance, info.app, {}, extensions));
+	}
+	else
+	{
+		rv_rif(Instance::Create(graphics.instance, info.app));
+	}
 
 	rv_debug_only(rv_rif(DebugMessenger::Create(graphics.debug, graphics.instance, combine(RV_SEVERITY_ERROR, RV_SEVERITY_WARNING), false)));
 	check_debug_static();
@@ -57,13 +70,27 @@ rv::Result rv::Graphics::Create(Graphics& graphics, const GraphicsInfo& info)
 		windowSurfaces.push_back(std::move(surface));
 		surfaces.push_back(windowSurfaces.back());
 	}
-	rv_rif(Device::Create(graphics.device, graphics.instance, DefaultDeviceRequirements(surfaces)));
+	PhysicalDeviceRequirements requirements = DefaultDeviceRequirements(surfaces);
+	if (info.headless)
+		requirements.extensions.extensions.clear();
+	rv_rif(Device::Create(graphics.device, graphics.instance, requirements));
 	check_debug_static();
 
 	rv_rif(MemoryAllocator::Create(graphics.allocator, graphics.instance, graphics.device));
 	check_debug_static();
 
-	rv_rif(StagingBufferManager::Create(graphics.manager, graphics.device, graphics.allocator, graphics.device.computeQueue));
+	rv_rif(PipelineCache::Create(graphics.pipelineCache, graphics.device, info.cacheDirectory));
+	check_debug_static();
+
+	// Both only need the device and the allocator, the upload queue spends most of its creation waiting for its thread
+	Result staging;
+	Result uploads;
+	JobCounter counter;
+	graphics.Jobs().Run([&]() { staging = StagingBufferManager::Create(graphics.manager, graphics.device, graphics.allocator, graphics.device.computeQueue); }, &counter);
+	graphics.Jobs().Run([&]() { uploads = UploadQueue::Create(graphics.uploads, graphics.device, graphics.allocator, graphics.device.computeQueue); }, &counter);
+	graphics.Jobs().Wait(counter);
+	rv_rif(staging);
+	rv_rif(uploads);
 	check_debug_static();
 
 	return result;
@@ -72,41 +99,127 @@ rv::Result rv::Graphics::Create(Graphics& graphics, const GraphicsInfo& info)
 rv::Result rv::Graphics::GetShader(Shader*& outshader, const char* name, ShaderType type)
 {
 	outshader = nullptr;
-	auto shader = shaders.find(name);
-	if (shader == shaders.end())
+	const std::string normalized = Shader::NormalizeName(name);
+	auto shader = shaders.find(Identifier(normalized.c_str()));
+	if (shader != shaders.end())
+	{
+		outshader = &shader->second;
+		return success;
+	}
+
+	// Only cache shaders that loaded, a failed load is reported again on the next request
+	rv_result;
+	ShaderSource source;
+	rv_rif(FindShader(source, name));
+	Shader s;
+	rv_rif(LoadShader(s, source, type));
+	Shader& cached = shaders[source.name];
+	cached = std::move(s);
+	outshader = &cached;
+	return result;
+}
+
+rv::Result rv::Graphics::LoadShaders(const std::vector<const char*>& names)
+{
+	rv_result;
+	std::vector<ShaderSource> sources;
+	for (const char* name : names)
+	{
+		ShaderSource source;
+		rv_rif(FindShader(source, name));
+		// Spellings of the same shader resolve to the same name
+		if (shaders.find(source.name) != shaders.end() || std::find_if(sources.begin(), sources.end(), [&source](const ShaderSource& s) { return s.name == source.name; }) != sources.end())
+			continue;
+		sources.push_back(std::move(source));
+	}
+
+	// The map isn't touched by the jobs, each one only creates its own module
+	std::vector<Shader> created(sources.size());
+	std::vector<Result> results(sources.size());
+	Jobs().ParallelFor(0, sources.size(), 1, [&](size_t i) {
+		results[i] = LoadShader(created[i], sources[i], RV_ST_NULL);
+	});
+
+	for (size_t i = 0; i < sources.size(); ++i)
+	{
+		if (results[i].failed())
+			result = results[i];
+		else
+			shaders[sources[i].name] = std::move(created[i]);
+	}
+	return result;
+}
+
+rv::Result rv::Graphics::LoadShaders()
+{
+	// The keys and the archive names stay where they are, so the shader map can refer to them
+	std::vector<const char*> names;
+	names.reserve(shaderFiles.size());
+	for (const auto& archive : shaderArchives)
+		for (u32 i = 0; i < archive.count; ++i)
+			names.push_back(archive.Name(archive.entries[i]));
+	for (const auto& file : shaderFiles)
+		names.push_back(file.first.c_str());
+	return LoadShaders(names);
+}
+
+rv::Result rv::Graphics::FindShader(ShaderSource& source, const char* name)
+{
+	const std::string normalized = Shader::NormalizeName(name);
+	const u64 hash = ShaderArchive::HashName(normalized.c_str());
+	for (const auto& archive : shaderArchives)
 	{
-		std::filesystem::path path(name);
-		path += ".spv";
-		if (!FileExists(path))
+		if (const ShaderArchive::Entry* entry = archive.Find(hash))
 		{
-			bool found = false;
-			for (const auto& d : shaderpaths)
-			{
-				auto p = std::filesystem::absolute(d);
-				if (FileExists(p += path))
-				{
-					found = true;
-					path = p;
-					break;
-				}
-				else if (FileExists((p = std::filesystem::absolute(d)) += std::filesystem::path("/bin/") += path))
-				{
-					found = true;
-					path = p;
-					break;
-				}
-			}
-			if (!found)
-				return rv_runtime_error(str("Shader \"", name, "\" not found"));
+			source.archive = &archive;
+			source.entry = entry;
+			source.name = archive.Name(*entry);
+			return success;
 		}
-		Shader& s = shaders[name];
-		Result result = Shader::Create(s, device, path.string().c_str(), type);
-		if (result.succeeded())
-			outshader = &s;
-		return result;
 	}
-	outshader = &shader->second;
-	return success;
+
+	auto file = shaderFiles.find(normalized);
+	if (file != shaderFiles.end())
+	{
+		source.path = file->second;
+		source.name = file->first.c_str();
+		return success;
+	}
+
+	source.path = name;
+	source.path += ".spv";
+	if (FileExists(source.path))
+	{
+		source.name = shaderFiles.emplace(normalized, source.path).first->first.c_str();
+		return success;
+	}
+	return rv_runtime_error(str("Shader \"", name, "\" not found"));
+}
+
+rv::Result rv::Graphics::LoadShader(Shader& shader, const ShaderSource& source, ShaderType type) const
+{
+	if (!source.entry)
+		return Shader::Create(shader, device, source.path.string().c_str(), type);
+	if (type == RV_ST_NULL)
+		return source.archive->CreateShader(shader, device, *source.entry);
+	return Shader::Create(shader, device, source.archive->Code(*source.entry), source.entry->codeSize, type);
+}
+
+void rv::Graphics::IndexShaders(const std::filesystem::path& directory)
+{
+	std::error_code error;
+	const auto absolute = std::filesystem::absolute(directory, error);
+	if (error || !std::filesystem::is_directory(absolute, error))
+		return;
+
+	for (auto it = std::filesystem::recursive_directory_iterator(absolute, error); !error && it != std::filesystem::recursive_directory_iterator(); it.increment(error))
+	{
+		if (!it->is_regular_file(error) || it->path().extension() != ".spv")
+			continue;
+		std::filesystem::path name = it->path().lexically_relative(absolute);
+		name.replace_extension();
+		shaderFiles.emplace(Shader::NormalizeName(name.generic_string()), it->path());
+	}
 }
 
 rv::Result rv::Graphics::CreateShader(const char* name, ShaderType type)
@@ -117,13 +230,27 @@ rv::Result rv::Graphics::CreateShader(const char* name, ShaderType type)
 
 rv::Result rv::Graphics::AddShaderPath(const char* path)
 {
-	if (std::filesystem::is_directory(path))
-		shaderpaths.push_back(path);
-	else
+	if (!std::filesystem::is_directory(path))
 		return failure;
+	shaderpaths.push_back(path);
+	IndexShaders(shaderpaths.back());
+	IndexShaders(shaderpaths.back() / "bin");
+
+	const std::filesystem::path archive = shaderpaths.back() / "shaders.rvsa";
+	if (FileExists(archive))
+		return AddShaderArchive(archive);
 	return success;
 }
 
+rv::Result rv::Graphics::AddShaderArchive(const std::filesystem::path& path)
+{
+	rv_result;
+	ShaderArchive archive;
+	rv_rif(ShaderArchive::Create(archive, path));
+	shaderArchives.push_back(std::move(archive));
+	return result;
+}
+
 rv::Result rv::Graphics::CreateShape(Shape& shape, const HeapBuffer<Vertex2>& vertices, const HeapBuffer<u16>& indices, const FColor& color)
 {
 	rv_result;
@@ -144,6 +271,59 @@ rv::Result rv::Graphics::CreateShape(Shape& shape, HeapBuffer<Vertex2>&& vertice
 	return Shape::Create(shape, *this, manager, std::move(vertices), std::move(indices), color);
 }
 
+rv::Result rv::Graphics::CreateShape(Shape& shape, const HeapBuffer<Vertex2>& vertices, const HeapBuffer<u16>& indices, const FColor& color, Shape::PendingUpload& pending)
+{
+	rv_result;
+	if (shape.invalid())
+		shape.set(NewDrawable());
+	if (InitStatic<Shape>())
+		rv_rif(Shape::InitStaticData(*this, setAllocator));
+	return Shape::Create(shape, *this, manager, uploads, vertices, indices, color, pending);
+}
+
+rv::Result rv::Graphics::CreateShape(Shape& shape, HeapBuffer<Vertex2>&& vertices, HeapBuffer<u16>&& indices, const FColor& color, Shape::PendingUpload& pending)
+{
+	rv_result;
+	if (shape.invalid())
+		shape.set(NewDrawable());
+	if (InitStatic<Shape>())
+		rv_rif(Shape::InitStaticData(*this, setAllocator));
+	return Shape::Create(shape, *this, manager, uploads, std::move(vertices), std::move(indices), color, pending);
+}
+
+rv::Result rv::Graphics::CreateShapeMesh(ShapeMesh& mesh, const HeapBuffer<Vertex2>& vertices, const HeapBuffer<u16>& indices)
+{
+	return InstancedShape::CreateMesh(mesh, *this, manager, vertices, indices);
+}
+
+rv::Result rv::Graphics::CreateInstancedShape(InstancedShape& shape, ShapeMesh mesh, const InstancedShape::Instance& instance)
+{
+	if (shape.invalid())
+		shape.set(NewDrawable());
+	return InstancedShape::Create(shape, *this, mesh, instance);
+}
+
+void rv::Graphics::BeginUploads()
+{
+	manager.BeginBatch();
+}
+
+rv::Result rv::Graphics::EndUploads()
+{
+	return manager.EndBatch();
+}
+
+rv::UploadQueue& rv::Graphics::GetUploadQueue()
+{
+	return uploads;
+}
+
+rv::JobSystem& rv::Graphics::Jobs()
+{
+	static JobSystem inline_jobs;
+	return jobs ? *jobs : inline_jobs;
+}
+
 rv::Drawable rv::Graphics::NewDrawable()
 {
 	if (freeDrawables.empty())
@@ -0,0 +1,69 @@
+#include "Engine/Graphics/Image.h"
+#include "Engine/Utility/Error.h"
+
+rv::Image::Image(Image&& rhs) noexcept
+	:
+	image(move(rhs.image)),
+	allocation(std::move(rhs.allocation)),
+	format(rhs.format),
+	size(rhs.size)
+{
+}
+
+rv::Image::~Image()
+{
+	Release();
+}
+
+rv::Image& rv::Image::operator=(Image&& rhs) noexcept
+{
+	Release();
+	image = move(rhs.image);
+	allocation = std::move(rhs.allocation);
+	format = rhs.format;
+	size = rhs.size;
+	return *this;
+}
+
+void rv::Image::Release()
+{
+	if (allocation.allocator && allocation.allocator->allocator)
+	{
+		if (image)
+		{
+			vmaDestroyImage(allocation.Allocator(), image, allocation.allocation);
+			allocation.allocation = nullptr;
+			image = nullptr;
+		}
+		else
+		{
+			allocation.Release();
+		}
+	}
+}
+
+rv::Result rv::Image::Create(Image& image, const MemoryAllocator& allocator, const Extent2D& size, VkFormat format, VkImageUsageFlags usage, VmaMemoryUsage memoryUsage)
+{
+	image.Release();
+	image.allocation = allocator;
+	image.format = format;
+	image.size = size;
+
+	VkImageCreateInfo createInfo{};
+	createInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+	createInfo.imageType = VK_IMAGE_TYPE_2D;
+	createInfo.format = format;
+	createInfo.extent = { size.width, size.height, 1 };
+	createInfo.mipLevels = 1;
+	createInfo.arrayLayers = 1;
+	createInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+	createInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+	createInfo.usage = usage;
+	createInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	createInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+	VmaAllocationCreateInfo allocation{};
+	allocation.usage = memoryUsage;
+
+	return rv_try_vkr(vmaCreateImage(allocator.allocator, &createInfo, &allocation, &image.image, &image.allocation.allocation, nullptr));
+}
@@ -2,7 +2,8 @@
 
 rv::IndexBuffer::IndexBuffer(IndexBuffer&& rhs) noexcept
 	:
-	Buffer(std::move(rhs))
+	Buffer(std::move(rhs)),
+	type(rhs.type)
 {
 }
 
@@ -14,6 +15,7 @@ rv::IndexBuffer::~IndexBuffer()
 rv::IndexBuffer& rv::IndexBuffer::operator=(IndexBuffer&& rhs) noexcept
 {
 	detail::move_buffers<Buffer>(*this, rhs);
+	type = rhs.type;
 	return *this;
 }
 
@@ -29,13 +31,13 @@ rv::Result rv::IndexBuffer::Create(IndexBuffer& buffer, const MemoryAllocator& a
 	return Buffer::Create(buffer, allocator, data, size, bufferUsage | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, memoryUsage);
 }
 
-rv::Result rv::IndexBuffer::Create(IndexBuffer& buffer, const StagingBufferManager& manager, const void* data, u64 size, VkIndexType type, VkBufferUsageFlags bufferUsage, VmaMemoryUsage memoryUsage)
+rv::Result rv::IndexBuffer::Create(IndexBuffer& buffer, StagingBufferManager& manager, const void* data, u64 size, VkIndexType type, VkBufferUsageFlags bufferUsage, VmaMemoryUsage memoryUsage)
 {
 	buffer.type = type;
 	return Buffer::Create(buffer, manager, data, size, bufferUsage | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, memoryUsage);
 }
 
-rv::Result rv::IndexBuffer::Create(IndexBuffer& buffer, StagingBuffer& staging, const StagingBufferManager& manager, const void* data, u64 size, VkIndexType type, VkBufferUsageFlags bufferUsage, VmaMemoryUsage memoryUsage)
+rv::Result rv::IndexBuffer::Create(IndexBuffer& buffer, StagingBuffer& staging, StagingBufferManager& manager, const void* data, u64 size, VkIndexType type, VkBufferUsageFlags bufferUsage, VmaMemoryUsage memoryUsage)
 {
 	buffer.type = type;
 	return Buffer::Create(buffer, staging, manager, data, size, bufferUsage | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, memoryUsage);
@@ -0,0 +1,178 @@
+#include "Engine/Graphics/OffscreenRenderer.h"
+#include "Engine/Utility/Error.h"
+#include "Engine/Utility/PerformanceLogger.h"
+#include "Engine/Core/Engine.h"
+#include <algorithm>
+#include <cstring>
+
+#ifdef RV_DEBUG
+#	define check_debug()		rv_rif(engine->graphics.debug.Check())
+#	define check_debug_static()	rv_rif(renderer.engine->graphics.debug.Check())
+#else
+#	define check_debug()
+#	define check_debug_static()
+#endif
+
+rv::OffscreenRenderer::~OffscreenRenderer()
+{
+	if (engine)
+		engine->graphics.device.Wait();
+}
+
+rv::Result rv::OffscreenRenderer::Create(OffscreenRenderer& renderer, Engine& engine, const Extent2D& size, const FColor& background, u32 imageCount, VkFormat format)
+{
+	rv_result;
+	rif_assert(imageCount);
+	rif_assert(size.width && size.height);
+
+	renderer.SetEngine(engine);
+	renderer.background = background;
+	renderer.format = format;
+	renderer.size = size;
+	rif_check_info(renderer.TexelSize(), "Unsupported OffscreenRenderer format");
+
+	rv_rif(renderer.CreateCommandPools());
+	rv_rif(renderer.CreatePasses(format, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL));
+
+	renderer.frameBuffers.resize(imageCount);
+	rv_rif(renderer.CreateImages());
+	rv_rif(renderer.AllocateDrawCommands());
+
+	renderer.fences.resize(imageCount);
+	for (auto& fence : renderer.fences)
+		rv_rif(Fence::Create(fence, engine.graphics.device, true));
+	check_debug_static();
+
+	renderer.Invalidate();
+	return result;
+}
+
+rv::Result rv::OffscreenRenderer::Render()
+{
+	rv_performance_scope("OffscreenRenderer::Render");
+	rv_result;
+
+	const u32 image = nextImage;
+	rv_rif(fences[image].Wait());
+
+	rv_rif(PrepareImage(image));
+	UpdateDrawables(image);
+
+	// Only reset right before the submit, a failure above leaves the fence signaled
+	rv_rif(fences[image].Reset());
+	rv_rif(drawCommands[image].Submit(engine->graphics.device.graphicsQueue, &fences[image]));
+	check_debug();
+
+	current = image;
+	nextImage = (image + 1) % ImageCount();
+	return result;
+}
+
+rv::Result rv::OffscreenRenderer::Wait() const
+{
+	std::vector<VkFence> wait(fences.size());
+	std::transform(fences.begin(), fences.end(), wait.begin(), [](const Fence& fence) { return fence.fence; });
+	if (wait.empty())
+		return success;
+	return Fence::Wait(engine->graphics.device, wait);
+}
+
+rv::Result rv::OffscreenRenderer::Resize(const Extent2D& newSize)
+{
+	rv_result;
+	rif_assert(newSize.width && newSize.height);
+	rv_rif(Wait());
+
+	// The passes only depend on the format, so the pipelines stay valid
+	size = newSize;
+	current = Optional<u32>::invalid_value;
+	rv_rif(CreateImages());
+	Invalidate();
+	return result;
+}
+
+rv::Result rv::OffscreenRenderer::Read(std::vector<u8>& pixels, u32 image) const
+{
+	rv_result;
+	rif_check(image < ImageCount());
+	rv_rif(fences[image].Wait());
+
+	const Buffer& buffer = readback[image];
+	const u64 bytes = (u64)size.width * size.height * TexelSize();
+	rif_try_vkr(vmaInvalidateAllocation(buffer.allocation.Allocator(), buffer.allocation.allocation, 0, VK_WHOLE_SIZE));
+
+	void* map = nullptr;
+	rif_try_vkr(vmaMapMemory(buffer.allocation.Allocator(), buffer.allocation.allocation, &map));
+	pixels.resize(bytes);
+	memcpy(pixels.data(), map, bytes);
+	vmaUnmapMemory(buffer.allocation.Allocator(), buffer.allocation.allocation);
+	return result;
+}
+
+rv::Result rv::OffscreenRenderer::Read(std::vector<u8>& pixels) const
+{
+	rv_result;
+	rif_check_info(current != Optional<u32>::invalid_value, "Nothing was rendered yet");
+	return Read(pixels, current);
+}
+
+rv::u32 rv::OffscreenRenderer::CurrentImage() const
+{
+	return current;
+}
+
+rv::Extent2D rv::OffscreenRenderer::Size() const
+{
+	return size;
+}
+
+VkFormat rv::OffscreenRenderer::Format() const
+{
+	return format;
+}
+
+rv::u32 rv::OffscreenRenderer::TexelSize() const
+{
+	switch (format)
+	{
+		case VK_FORMAT_R8G8B8A8_UNORM:
+		case VK_FORMAT_R8G8B8A8_SRGB:
+		case VK_FORMAT_B8G8R8A8_UNORM:
+		case VK_FORMAT_B8G8R8A8_SRGB:
+		case VK_FORMAT_A2B10G10R10_UNORM_PACK32:
+			return 4;
+		case VK_FORMAT_R16G16B16A16_SFLOAT:
+			return 8;
+		case VK_FORMAT_R32G32B32A32_SFLOAT:
+			return 16;
+		default:
+			return 0;
+	}
+}
+
+void rv::OffscreenRenderer::RecordAfterPass(const CommandBuffer& draw, size_t image) const
+{
+	draw.CopyImageToBuffer(images[image], readback[image]);
+	draw.HostReadBarrier(readback[image]);
+}
+
+rv::Result rv::OffscreenRenderer::CreateImages()
+{
+	rv_result;
+	const u32 count = (u32)frameBuffers.size();
+	images.resize(count);
+	views.resize(count);
+	readback.resize(count);
+	for (u32 i = 0; i < count; ++i)
+	{
+		// The old frame buffer and view still reference the image that is about to be replaced
+		frameBuffers[i].Release();
+		views[i].Release();
+		rv_rif(Image::Create(images[i], engine->graphics.allocator, size, format, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT));
+		rv_rif(ImageView::Create(views[i], engine->graphics.device, images[i].image, format));
+		rv_rif(FrameBuffer::Create(frameBuffers[i], engine->graphics.device, colorPass, size, views[i]));
+		rv_rif(Buffer::Create(readback[i], engine->graphics.allocator, (u64)size.width * size.height * TexelSize(), VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_GPU_TO_CPU));
+	}
+	check_debug();
+	return result;
+}
@@ -1,5 +1,6 @@
 #include "Engine/Graphics/Pipeline.h"
 #include "Engine/Utility/Error.h"
+#include <algorithm>
 
 template<>
 void rv::destroy(VkPipelineLayout layout, VkDevice device, VkInstance)
@@ -13,6 +14,11 @@ void rv::destroy(VkPipeline pipeline, VkDevice device, VkInstance)
 	vkDestroyPipeline(device, pipeline, nullptr);
 }
 
+static constexpr VkDynamicState dynamic_states[] = {
+	VK_DYNAMIC_STATE_VIEWPORT,
+	VK_DYNAMIC_STATE_SCISSOR
+};
+
 rv::PipelineLayout::PipelineLayout()
 {
 	vertexInput.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
@@ -21,11 +27,10 @@ rv::PipelineLayout::PipelineLayout()
 	rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
 	multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
 	colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+	dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
 
 	viewportState.viewportCount = 1;
-	viewportState.pViewports = &viewport;
 	viewportState.scissorCount = 1;
-	viewportState.pScissors = &scissor;
 
 	rasterizer.depthClampEnable = VK_FALSE;
 	rasterizer.rasterizerDiscardEnable = VK_FALSE;
@@ -47,6 +52,9 @@ rv::PipelineLayout::PipelineLayout()
 	colorBlending.attachmentCount = 1;
 	colorBlending.pAttachments = &colorBlendAttachment;
 
+	dynamicState.dynamicStateCount = (u32)std::size(dynamic_states);
+	dynamicState.pDynamicStates = dynamic_states;
+
 	SetSize(0);
 	SetTopology(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST);
 	SetLineWidth(1.0f);
@@ -57,6 +65,8 @@ rv::PipelineLayout::PipelineLayout(PipelineLayout&& rhs) noexcept
 	:
 	layout(move(rhs.layout)),
 	vertexInput(std::move(rhs.vertexInput)),
+	vertexBindings(std::move(rhs.vertexBindings)),
+	vertexAttributes(std::move(rhs.vertexAttributes)),
 	inputAssembly(std::move(rhs.inputAssembly)),
 	viewport(std::move(rhs.viewport)),
 	scissor(std::move(rhs.scissor)),
@@ -65,9 +75,12 @@ rv::PipelineLayout::PipelineLayout(PipelineLayout&& rhs) noexcept
 	multisampling(std::move(rhs.multisampling)),
 	colorBlendAttachment(std::move(rhs.colorBlendAttachment)),
 	colorBlending(std::move(rhs.colorBlending)),
+	dynamicState(std::move(rhs.dynamicState)),
 	device(move(rhs.device)),
-	setLayouts(std::move(rhs.setLayouts))
+	setLayouts(std::move(rhs.setLayouts)),
+	pushConstants(std::move(rhs.pushConstants))
 {
+	colorBlending.pAttachments = &colorBlendAttachment;
 }
 
 rv::PipelineLayout::~PipelineLayout()
@@ -79,6 +92,8 @@ rv::PipelineLayout& rv::PipelineLayout::operator=(PipelineLayout&& rhs) noexcept
 {
 	layout = move(rhs.layout);
 	vertexInput = std::move(rhs.vertexInput);
+	vertexBindings = std::move(rhs.vertexBindings);
+	vertexAttributes = std::move(rhs.vertexAttributes);
 	inputAssembly = std::move(rhs.inputAssembly);
 	viewport = std::move(rhs.viewport);
 	scissor = std::move(rhs.scissor);
@@ -87,8 +102,11 @@ rv::PipelineLayout& rv::PipelineLayout::operator=(PipelineLayout&& rhs) noexcept
 	multisampling = std::move(rhs.multisampling);
 	colorBlendAttachment = std::move(rhs.colorBlendAttachment);
 	colorBlending = std::move(rhs.colorBlending);
+	dynamicState = std::move(rhs.dynamicState);
 	device = move(rhs.device);
 	setLayouts = std::move(rhs.setLayouts);
+	pushConstants = std::move(rhs.pushConstants);
+	colorBlending.pAttachments = &colorBlendAttachment;
 	return *this;
 }
 
@@ -101,6 +119,8 @@ rv::Result rv::PipelineLayout::Create(PipelineLayout& layout, const Device& devi
 	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
 	pipelineLayoutInfo.setLayoutCount = (u32)layout.setLayouts.size();
 	pipelineLayoutInfo.pSetLayouts = layout.setLayouts.data();
+	pipelineLayoutInfo.pushConstantRangeCount = (u32)layout.pushConstants.size();
+	pipelineLayoutInfo.pPushConstantRanges = layout.pushConstants.data();
 
 	return rv_try_vkr(vkCreatePipelineLayout(device.device, &pipelineLayoutInfo, nullptr, &layout.layout));
 }
@@ -175,6 +195,18 @@ void rv::PipelineLayout::AddShader(const Shader& shader)
 	shaderStageInfo.module = shader.shader;
 	shaderStageInfo.pName = "main";
 	shaderStages.push_back(shaderStageInfo);
+
+	for (const auto& range : shader.reflection.pushConstants)
+	{
+		// Stages that see the same block share one range
+		auto it = std::find_if(pushConstants.begin(), pushConstants.end(), [&range](const VkPushConstantRange& r) {
+			return r.offset == range.offset && r.size == range.size;
+		});
+		if (it == pushConstants.end())
+			pushConstants.push_back(range);
+		else
+			it->stageFlags |= range.stageFlags;
+	}
 }
 
 void rv::PipelineLayout::AddRenderPass(const RenderPass& pass, u32 subpass)
@@ -190,10 +222,23 @@ void rv::PipelineLayout::AddLayout(const DescriptorSetLayout& layout)
 
 void rv::PipelineLayout::SetVertexType(const VertexDescriptor& vertex)
 {
-	vertexInput.pVertexAttributeDescriptions = vertex.attributes;
-	vertexInput.vertexAttributeDescriptionCount = (u32)vertex.nAttributes;
-	vertexInput.pVertexBindingDescriptions = vertex.binding;
-	vertexInput.vertexBindingDescriptionCount = 1;
+	if (!vertex.instanceBinding)
+	{
+		vertexInput.pVertexAttributeDescriptions = vertex.attributes;
+		vertexInput.vertexAttributeDescriptionCount = (u32)vertex.nAttributes;
+		vertexInput.pVertexBindingDescriptions = vertex.binding;
+		vertexInput.vertexBindingDescriptionCount = 1;
+		return;
+	}
+
+	// Both bindings have to be contiguous, so they're copied into the layout
+	vertexBindings = { *vertex.binding, *vertex.instanceBinding };
+	vertexAttributes.assign(vertex.attributes, vertex.attributes + vertex.nAttributes);
+	vertexAttributes.insert(vertexAttributes.end(), vertex.instanceAttributes, vertex.instanceAttributes + vertex.nInstanceAttributes);
+	vertexInput.pVertexAttributeDescriptions = vertexAttributes.data();
+	vertexInput.vertexAttributeDescriptionCount = (u32)vertexAttributes.size();
+	vertexInput.pVertexBindingDescriptions = vertexBindings.data();
+	vertexInput.vertexBindingDescriptionCount = (u32)vertexBindings.size();
 }
 
 rv::Pipeline::Pipeline(Pipeline&& rhs) noexcept
@@ -215,13 +260,13 @@ rv::Pipeline& rv::Pipeline::operator=(Pipeline&& rhs) noexcept
 	return *this;
 }
 
-rv::Result rv::Pipeline::Create(Pipeline& pipeline, const Device& device, const PipelineLayout& layout)
+rv::Result rv::Pipeline::Create(Pipeline& pipeline, const Device& device, const PipelineLayout& layout, const PipelineCache* cache)
 {
 	pipeline.Release();
 	pipeline.device = &device;
 	VkGraphicsPipelineCreateInfo pipelineInfo{};
 	FillCreateInfo(pipelineInfo, layout);
-	return rv_try_vkr(vkCreateGraphicsPipelines(device.device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline.pipeline));
+	return rv_try_vkr(vkCreateGraphicsPipelines(device.device, cache ? cache->cache : VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline.pipeline));
 }
 
 void rv::Pipeline::Release()
@@ -230,7 +275,7 @@ void rv::Pipeline::Release()
 		release(pipeline, *device);
 }
 
-rv::Result rv::Pipeline::Create(const std::vector<std::reference_wrapper<Pipeline>>& pipelines, const Device& device, const std::vector<std::reference_wrapper<const PipelineLayout>>& layouts)
+rv::Result rv::Pipeline::Create(const std::vector<std::reference_wrapper<Pipeline>>& pipelines, const Device& device, const std::vector<std::reference_wrapper<const PipelineLayout>>& layouts, const PipelineCache* cache)
 {
 	rv_result;
 	rif_assert(pipelines.size() == layouts.size());
@@ -247,7 +292,7 @@ rv::Result rv::Pipeline::Create(const std::vector<std::reference_wrapper<Pipelin
 		FillCreateInfo(createInfo[i], layouts[i]);
 	std::transform(pipelines.begin(), pipelines.end(), vkpipelines.begin(), [](const Pipeline& pipeline) { return pipeline.pipeline; });
 	
-	rif_try_vkr(vkCreateGraphicsPipelines(device.device, VK_NULL_HANDLE, (u32)createInfo.size(), createInfo.data(), nullptr, vkpipelines.data()));
+	rif_try_vkr(vkCreateGraphicsPipelines(device.device, cache ? cache->cache : VK_NULL_HANDLE, (u32)createInfo.size(), createInfo.data(), nullptr, vkpipelines.data()));
 
 	for (u32 i = 0; i < layouts.size(); ++i)
 		pipelines[i].get().pipeline = vkpipelines[i];
@@ -266,6 +311,7 @@ void rv::Pipeline::FillCreateInfo(VkGraphicsPipelineCreateInfo& info, const Pipe
 	info.pRasterizationState = &layout.rasterizer;
 	info.pMultisampleState = &layout.multisampling;
 	info.pColorBlendState = &layout.colorBlending;
+	info.pDynamicState = &layout.dynamicState;
 	info.layout = layout.layout;
 	info.renderPass = layout.pass;
 	info.subpass = layout.subpass;
@@ -323,9 +369,9 @@ void rv::FullPipeline::Release()
 
 #include <iostream>
 
-rv::Result rv::FullPipeline::Create(FullPipeline& pipeline, const Device& device)
+rv::Result rv::FullPipeline::Create(FullPipeline& pipeline, const Device& device, const PipelineCache* cache)
 {
 	rv_result;
 	rv_rif(PipelineLayout::Create(pipeline.layout, device));
-	return Pipeline::Create(pipeline.pipeline, device, pipeline.layout);
+	return Pipeline::Create(pipeline.pipeline, device, pipeline.layout, cache);
 }
@@ -0,0 +1,162 @@
+#include "Engine/Graphics/PipelineCache.h"
+#include "Engine/Utility/Error.h"
+#include "Engine/Utility/String.h"
+#include "Engine/Utility/File.h"
+#include <fstream>
+#include <cstring>
+#include <cstdio>
+
+template<>
+void rv::destroy(VkPipelineCache cache, VkDevice device, VkInstance)
+{
+	vkDestroyPipelineCache(device, cache, nullptr);
+}
+
+static rv::u64 hash_data(const std::vector<rv::u8>& data)
+{
+	// FNV-1a, only used to detect truncated or corrupted files
+	rv::u64 hash = 0xcbf29ce484222325;
+	for (rv::u8 byte : data)
+		hash = (hash ^ byte) * 0x100000001b3;
+	return hash;
+}
+
+rv::PipelineCache::PipelineCache(PipelineCache&& rhs) noexcept
+	:
+	cache(move(rhs.cache)),
+	device(move(rhs.device)),
+	path(std::move(rhs.path))
+{
+}
+
+rv::PipelineCache::~PipelineCache()
+{
+	Release();
+}
+
+rv::PipelineCache& rv::PipelineCache::operator=(PipelineCache&& rhs) noexcept
+{
+	Release();
+	cache = move(rhs.cache);
+	device = move(rhs.device);
+	path = std::move(rhs.path);
+	return *this;
+}
+
+void rv::PipelineCache::Release()
+{
+	if (device && cache)
+	{
+		Save();
+		release(cache, *device);
+	}
+	device = nullptr;
+}
+
+rv::Result rv::PipelineCache::Create(PipelineCache& cache, const Device& device, const std::filesystem::path& directory)
+{
+	cache.Release();
+	cache.device = &device;
+
+	const VkPhysicalDeviceProperties& properties = device.physical.properties;
+	std::string name = "pipelines_";
+	for (u8 byte : properties.pipelineCacheUUID)
+	{
+		char hex[3];
+		snprintf(hex, sizeof(hex), "%02x", byte);
+		name += hex;
+	}
+	cache.path = directory / (name += ".cache");
+
+	std::vector<u8> data;
+	if (FileExists(cache.path))
+	{
+		std::ifstream file(cache.path, std::ios::binary);
+		Header header{};
+		if (file.read(reinterpret_cast<char*>(&header), sizeof(header)) && header.size <= std::filesystem::file_size(cache.path) - sizeof(header))
+		{
+			data.resize(header.size);
+			file.read(reinterpret_cast<char*>(data.data()), data.size());
+			if (!file || !cache.Validate(header, data))
+				data.clear();
+		}
+	}
+
+	VkPipelineCacheCreateInfo createInfo{};
+	createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+	createInfo.initialDataSize = data.size();
+	createInfo.pInitialData = data.empty() ? nullptr : data.data();
+	return rv_try_vkr(vkCreatePipelineCache(device.device, &createInfo, nullptr, &cache.cache));
+}
+
+rv::Result rv::PipelineCache::Save() const
+{
+	rv_result;
+	rif_assert(device && cache);
+
+	size_t size = 0;
+	rif_try_vkr(vkGetPipelineCacheData(device->device, cache, &size, nullptr));
+	std::vector<u8> data(size);
+	rif_try_vkr(vkGetPipelineCacheData(device->device, cache, &size, data.data()));
+	data.resize(size);
+
+	Header header{};
+	FillHeader(header);
+	header.size = data.size();
+	header.hash = hash_data(data);
+
+	// Written next to the old file first, so a crash while saving can't leave a half written cache behind
+	std::filesystem::path temp = path;
+	temp += ".tmp";
+	{
+		std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+		if (!file.is_open())
+			return rv_runtime_error(str("Unable to write pipeline cache \"", temp.string(), "\""));
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(reinterpret_cast<const char*>(data.data()), data.size());
+		if (!file)
+			return rv_runtime_error(str("Unable to write pipeline cache \"", temp.string(), "\""));
+	}
+
+	std::error_code error;
+	std::filesystem::rename(temp, path, error);
+	if (error)
+		return rv_runtime_error(str("Unable to replace pipeline cache \"", path.string(), "\": ", error.message()));
+	return result;
+}
+
+void rv::PipelineCache::FillHeader(Header& header) const
+{
+	const VkPhysicalDeviceProperties& properties = device->physical.properties;
+	header.magic = magic;
+	header.version = header_version;
+	header.vendorID = properties.vendorID;
+	header.deviceID = properties.deviceID;
+	header.driverVersion = properties.driverVersion;
+	memcpy(header.uuid, properties.pipelineCacheUUID, VK_UUID_SIZE);
+}
+
+bool rv::PipelineCache::Validate(const Header& header, const std::vector<u8>& data) const
+{
+	Header expected{};
+	FillHeader(expected);
+	if (header.magic != expected.magic || header.version != expected.version)
+		return false;
+	if (header.vendorID != expected.vendorID || header.deviceID != expected.deviceID || header.driverVersion != expected.driverVersion)
+		return false;
+	if (memcmp(header.uuid, expected.uuid, VK_UUID_SIZE) != 0)
+		return false;
+	if (header.size != data.size() || header.hash != hash_data(data))
+		return false;
+
+	// The driver validates its own header too, but some drivers have been known to crash on foreign data
+	VkPipelineCacheHeaderVersionOne vulkan{};
+	if (data.size() < sizeof(vulkan))
+		return false;
+	memcpy(&vulkan, data.data(), sizeof(vulkan));
+	return
+		vulkan.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+		vulkan.vendorID == expected.vendorID &&
+		vulkan.deviceID == expected.deviceID &&
+		memcmp(vulkan.pipelineCacheUUID, expected.uuid, VK_UUID_SIZE) == 0;
+}
@@ -71,7 +71,7 @@ rv::u32 rv::RenderPassDescriptor::AddSubpass()
 	return index;
 }
 
-void rv::RenderPassDescriptor::AddColorAttachment(u32 subpass, VkFormat format, VkAttachmentLoadOp loadOp, VkAttachmentStoreOp storeOp)
+void rv::RenderPassDescriptor::AddColorAttachment(u32 subpass, VkFormat format, VkAttachmentLoadOp loadOp, VkAttachmentStoreOp storeOp, VkImageLayout finalLayout)
 {
 	attachments.push_back({});
 	VkAttachmentDescription& colorAttachment = attachments.back();
@@ -82,7 +82,7 @@ void rv::RenderPassDescriptor::AddColorAttachment(u32 subpass, VkFormat format,
 	colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 	colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
 	colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-	colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+	colorAttachment.finalLayout = finalLayout;
 
 	VkAttachmentReference ref{};
 	ref.attachment = (u32)attachments.size() - 1;
@@ -107,3 +107,15 @@ void rv::RenderPassDescriptor::AddColorDependency(u32 subpass)
 	dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
 	AddDependency(dependency);
 }
+
+void rv::RenderPassDescriptor::AddTransferDependency(u32 subpass)
+{
+	VkSubpassDependency dependency{};
+	dependency.srcSubpass = subpass;
+	dependency.dstSubpass = VK_SUBPASS_EXTERNAL;
+	dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+	dependency.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	dependency.dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+	dependency.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+	AddDependency(dependency);
+}
@@ -1,7 +1,17 @@
 #include "Engine/Graphics/Renderer.h"
+#include "Engine/Graphics/GraphicsHelper.h"
 #include "Engine/Core/Engine.h"
 #include "Engine/Utility/Error.h"
+#include "Engine/Utility/PerformanceLogger.h"
 #include "Engine/Utility/String.h"
+#include <algorithm>
+#include <limits>
+
+#ifdef RV_DEBUG
+#	define check_debug()		rv_rif(engine->graphics.debug.Check())
+#else
+#	define check_debug()
+#endif
 
 rv::Renderer::Renderer(Engine& e)
 	:
@@ -14,6 +24,13 @@ rv::Result rv::Renderer::Render()
 	return success;
 }
 
+rv::Result rv::Renderer::Wait() const
+{
+	if (engine)
+		return engine->graphics.device.Wait();
+	return success;
+}
+
 void rv::Renderer::SetEngine(Engine& e)
 {
 	engine = &e;
@@ -45,3 +62,325 @@ rv::Result rv::Renderer::PrepNewPipeline(FullPipeline*& pipeline, const Pipeline
 
 	return result;
 }
+
+rv::Result rv::Renderer::GetPipeline(FullPipeline*& pipeline, const PipelineLayoutDescriptor& layout)
+{
+	rv_result;
+	rif_assert(engine);
+
+	pipeline = GetCachedPipeline(layout);
+	if (pipeline)
+		return success;
+
+	result = PrepNewPipeline(pipeline, layout);
+	if (result.failed())
+	{
+		pipeline = nullptr;
+		return result;
+	}
+
+	pipeline->layout.pass = colorPass.pass;
+
+	result = FullPipeline::Create(*pipeline, engine->graphics.device, &engine->graphics.pipelineCache);
+	if (result.failed())
+		pipeline = nullptr;
+
+	check_debug();
+
+	return result;
+}
+
+rv::Result rv::Renderer::AddPipeline(const PipelineLayoutDescriptor& layout)
+{
+	FullPipeline* pipeline;
+	return GetPipeline(pipeline, layout);
+}
+
+// The per-image data and the draw commands catch up in PrepareImage, so creating a drawable never waits for the GPU.
+// The buffers of a shape stream in on the upload queue, it is drawn from the first image prepared after they arrived.
+rv::Result rv::Renderer::CreateShape(Shape& shape, const HeapBuffer<Vertex2>& vertices, const HeapBuffer<u16>& indices, const FColor& color)
+{
+	rv_result;
+	Shape::PendingUpload pending;
+	rv_rif(engine->graphics.CreateShape(shape, vertices, indices, color, pending));
+	pendingShapes.push_back(std::move(pending));
+	return AddDrawable(shape);
+}
+
+rv::Result rv::Renderer::CreateShape(Shape& shape, HeapBuffer<Vertex2>&& vertices, HeapBuffer<u16>&& indices, const FColor& color)
+{
+	rv_result;
+	Shape::PendingUpload pending;
+	rv_rif(engine->graphics.CreateShape(shape, std::move(vertices), std::move(indices), color, pending));
+	pendingShapes.push_back(std::move(pending));
+	return AddDrawable(shape);
+}
+
+rv::Result rv::Renderer::CreateInstancedShape(InstancedShape& shape, ShapeMesh mesh, const Vector2& position, const Vector2& scale, const FColor& color)
+{
+	rv_result;
+	rv_rif(engine->graphics.CreateInstancedShape(shape, mesh, InstancedShape::Instance(position, scale, color)));
+	return AddDrawable(shape);
+}
+
+rv::Result rv::Renderer::Record(size_t index)
+{
+	rv_result;
+	rv_rif(InitImageData((u32)index));
+	rv_rif(RecordSecondaries(index, 1));
+	rv_rif(RecordPrimary(index));
+	if (index < staleImages.size())
+		staleImages[index] = false;
+	return result;
+}
+
+rv::Result rv::Renderer::RecordAll()
+{
+	rv_performance_scope("Renderer::RecordAll");
+	rv_result;
+	for (u32 i = 0; i < ImageCount(); ++i)
+		rv_rif(InitImageData(i));
+	rv_rif(RecordSecondaries(0, drawCommands.size()));
+	for (size_t i = 0; i < drawCommands.size(); ++i)
+		rv_rif(RecordPrimary(i));
+	staleImages.assign(drawCommands.size(), false);
+	return result;
+}
+
+void rv::Renderer::Invalidate()
+{
+	staleImages.assign(drawCommands.size(), true);
+}
+
+rv::u32 rv::Renderer::ImageCount() const
+{
+	return (u32)frameBuffers.size();
+}
+
+rv::u32 rv::Renderer::CurrentImage() const
+{
+	return Optional<u32>::invalid_value;
+}
+
+rv::Result rv::Renderer::CreateCommandPools()
+{
+	rv_result;
+	rv_rif(CommandPool::CreateGraphics(drawPool, engine->graphics.device, true));
+	recordPools.resize(std::clamp<size_t>(engine->jobs.ThreadCount(), 1, max_recording_threads));
+	for (auto& pool : recordPools)
+		rv_rif(CommandPool::CreateGraphics(pool, engine->graphics.device, true));
+	check_debug();
+	return result;
+}
+
+rv::Result rv::Renderer::CreatePasses(VkFormat format, VkImageLayout finalLayout)
+{
+	rv_result;
+	RenderPassDescriptor color;
+	color.AddSubpass();
+	color.AddColorAttachment(0, format, VK_ATTACHMENT_LOAD_OP_DONT_CARE, VK_ATTACHMENT_STORE_OP_STORE, finalLayout);
+	color.AddColorDependency();
+	if (finalLayout == VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL)
+		color.AddTransferDependency();
+	rv_rif(RenderPass::Create(colorPass, engine->graphics.device, color));
+	check_debug();
+	RenderPassDescriptor clear;
+	clear.AddSubpass();
+	clear.AddColorAttachment(0, format, VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE, finalLayout);
+	clear.AddColorDependency();
+	if (finalLayout == VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL)
+		clear.AddTransferDependency();
+	rv_rif(RenderPass::Create(clearPass, engine->graphics.device, clear));
+	check_debug();
+	return result;
+}
+
+rv::Result rv::Renderer::RebuildPipelines()
+{
+	rv_result;
+	std::vector<FullPipeline*> rebuild;
+	rebuild.reserve(pipelines.size());
+	for (auto& pipeline : pipelines)
+	{
+		pipeline.second.layout.pass = colorPass.pass;
+		rebuild.push_back(&pipeline.second);
+	}
+	std::vector<Result> results(rebuild.size());
+	engine->jobs.ParallelFor(0, rebuild.size(), 1, [this, &rebuild, &results](size_t i) {
+		results[i] = Pipeline::Create(rebuild[i]->pipeline, engine->graphics.device, rebuild[i]->layout, &engine->graphics.pipelineCache);
+	});
+	for (const Result& r : results)
+		rv_rif(r);
+	check_debug();
+	return result;
+}
+
+rv::Result rv::Renderer::AllocateDrawCommands()
+{
+	rv_result;
+	drawCommands.resize(frameBuffers.size());
+	for (auto& draw : drawCommands)
+		if (!draw.buffer)
+			rv_rif(CommandBuffer::Create(draw, engine->graphics.device, drawPool));
+	return result;
+}
+
+rv::Result rv::Renderer::InitImageData(u32 image)
+{
+	rv_result;
+	Graphics& graphics = engine->graphics;
+	if (initializedPipelines.contains(typeid(Shape).hash_code()))
+		rv_rif(Shape::InitImageData(graphics, *this, graphics.setAllocator, graphics.device, graphics.allocator, image));
+	if (initializedPipelines.contains(typeid(InstancedShape).hash_code()))
+		rv_rif(InstancedShape::InitImageData(graphics, *this, graphics.device, graphics.allocator, image));
+	return result;
+}
+
+rv::Result rv::Renderer::PrepareImage(u32 image)
+{
+	rv_result;
+	rv_rif(FinishUploads());
+	if (image < staleImages.size() && !staleImages[image])
+		return result;
+	return Record(image);
+}
+
+rv::Result rv::Renderer::FinishUploads()
+{
+	rv_result;
+	for (size_t i = 0; i < pendingShapes.size();)
+	{
+		Result upload;
+		if (!Shape::FinishUpload(engine->graphics, pendingShapes[i], upload))
+		{
+			++i;
+			continue;
+		}
+		// A failed shape is reported once and never drawn
+		pendingShapes.erase(pendingShapes.begin() + i);
+		rv_rif(upload);
+		Invalidate();
+	}
+	return result;
+}
+
+void rv::Renderer::UpdateDrawables(u32 image)
+{
+	for (const auto& recorder : recorders)
+		if (recorder.updateFunction)
+			recorder.updateFunction(engine->graphics, *this, image);
+}
+
+void rv::Renderer::RecordAfterPass(const CommandBuffer& draw, size_t image) const
+{
+}
+
+size_t rv::Renderer::SplitRecorders()
+{
+	slots.clear();
+	size_t units = 0;
+	for (size_t r = 0; r < recorders.size(); ++r)
+	{
+		if (!recorders[r].countFunction)
+		{
+			slots.push_back({ r, { 0, std::numeric_limits<u32>::max() } });
+			units++;
+			continue;
+		}
+
+		const u32 count = recorders[r].countFunction(engine->graphics);
+		const u32 nRanges = (u32)std::clamp<size_t>((count + record_range_units - 1) / record_range_units, 1, recordPools.size());
+		for (u32 i = 0; i < nRanges; ++i)
+		{
+			const u32 first = (u32)((u64)count * i / nRanges);
+			const u32 last = (u32)((u64)count * (i + 1) / nRanges);
+			slots.push_back({ r, { first, last - first } });
+		}
+		units += count;
+	}
+	return units;
+}
+
+rv::Result rv::Renderer::AllocateSecondaries()
+{
+	rv_result;
+	secondaryCommands.resize(drawCommands.size());
+	for (size_t i = 0; i < secondaryCommands.size(); ++i)
+	{
+		auto& image = secondaryCommands[i];
+		// Images recorded with more slots before keep their extra buffers, the pool of a slot never changes
+		if (image.size() < slots.size())
+			image.resize(slots.size());
+		for (size_t s = 0; s < image.size(); ++s)
+			if (!image[s].buffer)
+				rv_rif(CommandBuffer::Create(image[s], engine->graphics.device, recordPools[(i + s) % recordPools.size()], VK_COMMAND_BUFFER_LEVEL_SECONDARY));
+	}
+	return result;
+}
+
+rv::Result rv::Renderer::RecordSecondaries(size_t first, size_t count)
+{
+	rv_result;
+	const size_t units = SplitRecorders();
+	rv_rif(AllocateSecondaries());
+
+	const size_t end = first + count;
+	const size_t nPools = recordPools.size();
+	if (nPools > 1 && slots.size() * count > 1 && units * count >= parallel_recording_threshold)
+	{
+		// Job t records every secondary allocated from recordPools[t], for all the images being recorded.
+		// The record functions only read the drawable pools, which aren't modified while recording.
+		std::vector<Result> results(nPools);
+		engine->jobs.ParallelFor(0, nPools, 1, [this, first, end, nPools, &results](size_t t) {
+			for (size_t i = first; i < end; ++i)
+			{
+				for (size_t s = (t + nPools - i % nPools) % nPools; s < slots.size(); s += nPools)
+				{
+					Result result = RecordSecondary(s, i);
+					if (result.failed())
+					{
+						results[t] = result;
+						return;
+					}
+				}
+			}
+		});
+		for (const Result& r : results)
+			rv_rif(r);
+	}
+	else
+	{
+		for (size_t i = first; i < end; ++i)
+			for (size_t s = 0; s < slots.size(); ++s)
+				rv_rif(RecordSecondary(s, i));
+	}
+	return result;
+}
+
+rv::Result rv::Renderer::RecordSecondary(size_t slot, size_t image)
+{
+	rv_result;
+	const RecordSlot& s = slots[slot];
+	const DrawableRecorder& r = recorders[s.recorder];
+	CommandBuffer& draw = secondaryCommands[image][slot];
+	rv_rif(draw.Begin(clearPass, frameBuffers[image]));
+	draw.BindPipeline(r.pipeline->pipeline);
+	// Dynamic state isn't inherited from the primary buffer
+	draw.SetViewport(size);
+	r.recordFunction(draw, engine->graphics, *this, r, (u32)image, s.range);
+	return draw.End();
+}
+
+rv::Result rv::Renderer::RecordPrimary(size_t image)
+{
+	rv_result;
+	CommandBuffer& draw = drawCommands[image];
+	rv_rif(draw.Begin());
+	// The clear and every drawable share one render pass, the frame is a single submit
+	draw.StartRenderPass(clearPass, frameBuffers[image], 0, size, background, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+	// Buffers past the current slots were recorded for more ranges before and are stale
+	draw.ExecuteCommands(secondaryCommands[image].data(), (u32)slots.size());
+	draw.EndRenderPass();
+	RecordAfterPass(draw, image);
+	return draw.End();
+}
@@ -1,9 +1,10 @@
 #include "Engine/Graphics/Shader.h"
 #include "Engine/Utility/Error.h"
 #include "Engine/Utility/String.h"
-#include "Engine/Utility/HeapBuffer.h"
-#include <filesystem>
-#include <fstream>
+#include "Engine/Utility/MappedFile.h"
+#include <cstring>
+#include <cctype>
+#include <algorithm>
 
 const char* rv::Shader::vulkan_path = nullptr;
 
@@ -17,6 +18,7 @@ rv::Shader::Shader(Shader&& rhs) noexcept
 	:
 	shader(move(rhs.shader)),
 	type(std::move(rhs.type)),
+	reflection(std::move(rhs.reflection)),
 	device(move(rhs.device))
 {
 }
@@ -30,6 +32,7 @@ rv::Shader& rv::Shader::operator=(Shader&& rhs) noexcept
 {
 	shader = move(rhs.shader);
 	type = std::move(rhs.type);
+	reflection = std::move(rhs.reflection);
 	device = move(rhs.device);
 	return *this;
 }
@@ -39,36 +42,34 @@ void rv::Shader::Release()
 	if (device)
 		release(shader, *device);
 	type = RV_ST_NULL;
+	reflection.Clear();
 	device = nullptr;
 }
 
 rv::Result rv::Shader::Create(Shader& shader, const Device& device, const char* filename, ShaderType type)
+{
+	rv_result;
+	MappedFile file;
+	rv_rif(MappedFile::Create(file, filename));
+	return Create(shader, device, file.data, file.size, type == RV_ST_NULL ? GetShaderTypeFromFile(filename) : type);
+}
+
+rv::Result rv::Shader::Create(Shader& shader, const Device& device, const void* code, u64 size, ShaderType type)
 {
 	shader.Release();
 
 	shader.device = &device;
+	shader.type = type;
 	rv_result;
-
-	if (type == RV_ST_NULL)
-		shader.type = GetShaderTypeFromFile(filename);
-	else
-		shader.type = type;
-
-	rif_try_file(filename);
-
-	size_t filesize = std::filesystem::file_size(filename);
-	HeapBuffer<char> code(filesize);
-
-	std::ifstream file(filename, std::ios::binary);
-	if (!file.is_open())
-		return failed_file;
-
-	file.read(code.data(), filesize);
+	rif_check_info(code && size && size % sizeof(u32) == 0, "Invalid SPIR-V code");
+	rv_rif(ShaderReflection::Create(shader.reflection, code, size));
+	if (shader.type == RV_ST_NULL)
+		shader.type = (ShaderType)detail::get_flag_bit(shader.reflection.stage);
 
 	VkShaderModuleCreateInfo createInfo{};
 	createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-	createInfo.codeSize = code.size();
-	createInfo.pCode = reinterpret_cast<const u32*>(code.data());
+	createInfo.codeSize = size;
+	createInfo.pCode = reinterpret_cast<const u32*>(code);
 	
 	return rv_try_vkr(vkCreateShaderModule(device.device, &createInfo, nullptr, &shader.shader));
 }
@@ -121,3 +122,10 @@ rv::ShaderType rv::Shader::GetShaderTypeFromFile(const char* path)
 		return RV_ST_CALLABLE;
 	return RV_ST_NULL;
 }
+
+std::string rv::Shader::NormalizeName(std::string name)
+{
+	std::replace(name.begin(), name.end(), '\\', '/');
+	std::transform(name.begin(), name.end(), name.begin(), [](char c) { return (char)std::tolower((unsigned char)c); });
+	return name;
+}
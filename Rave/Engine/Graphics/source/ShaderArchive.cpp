@@ -0,0 +1,184 @@
+#include "Engine/Graphics/ShaderArchive.h"
+#include "Engine/Utility/Error.h"
+#include "Engine/Utility/String.h"
+#include "Engine/Utility/Hash.h"
+#include <algorithm>
+#include <fstream>
+
+static constexpr rv::u64 code_alignment = 16;
+
+static rv::u64 align(rv::u64 offset)
+{
+	return (offset + code_alignment - 1) / code_alignment * code_alignment;
+}
+
+rv::ShaderArchive::ShaderArchive(ShaderArchive&& rhs) noexcept
+	:
+	file(std::move(rhs.file)),
+	entries(move(rhs.entries)),
+	count(rhs.count)
+{
+	rhs.count = 0;
+}
+
+rv::ShaderArchive::~ShaderArchive()
+{
+	Release();
+}
+
+rv::ShaderArchive& rv::ShaderArchive::operator=(ShaderArchive&& rhs) noexcept
+{
+	file = std::move(rhs.file);
+	entries = move(rhs.entries);
+	count = rhs.count;
+	rhs.count = 0;
+	return *this;
+}
+
+void rv::ShaderArchive::Release()
+{
+	file.Release();
+	entries = nullptr;
+	count = 0;
+}
+
+rv::Result rv::ShaderArchive::Create(ShaderArchive& archive, const std::filesystem::path& path)
+{
+	archive.Release();
+	rv_result;
+	rv_rif(MappedFile::Create(archive.file, path));
+
+	const u64 size = archive.file.size;
+	const Header* header = reinterpret_cast<const Header*>(archive.file.data);
+	auto invalid = [&archive, &path]() {
+		archive.Release();
+		return rv_runtime_error(str("\"", path.string(), "\" isn't a valid shader archive"));
+	};
+
+	if (size < sizeof(Header) || header->magic != magic || header->version != archive_version)
+		return invalid();
+	if ((size - sizeof(Header)) / sizeof(Entry) < header->count)
+		return invalid();
+
+	// Everything is checked once here, so lookups can trust the offsets
+	const Entry* entries = reinterpret_cast<const Entry*>(archive.file.data + sizeof(Header));
+	for (u32 i = 0; i < header->count; ++i)
+	{
+		const Entry& entry = entries[i];
+		if (i > 0 && entries[i - 1].name >= entry.name)
+			return invalid();
+		if (entry.nameOffset >= size || size - entry.nameOffset <= entry.nameSize || archive.file.data[entry.nameOffset + entry.nameSize] != 0)
+			return invalid();
+		if (entry.codeOffset % sizeof(u32) != 0 || entry.codeSize % sizeof(u32) != 0 || entry.codeOffset > size || size - entry.codeOffset < entry.codeSize)
+			return invalid();
+	}
+
+	archive.entries = entries;
+	archive.count = header->count;
+	return result;
+}
+
+rv::Result rv::ShaderArchive::Write(const std::filesystem::path& path, std::vector<File> files)
+{
+	rv_result;
+	for (auto& f : files)
+		f.name = Shader::NormalizeName(f.name);
+	std::sort(files.begin(), files.end(), [](const File& a, const File& b) { return HashName(a.name.c_str()) < HashName(b.name.c_str()); });
+
+	Header header{};
+	header.magic = magic;
+	header.version = archive_version;
+	header.count = (u32)files.size();
+
+	std::vector<Entry> entries(files.size());
+	u64 offset = sizeof(Header) + sizeof(Entry) * entries.size();
+	for (size_t i = 0; i < files.size(); ++i)
+	{
+		entries[i].name = HashName(files[i].name.c_str());
+		if (i > 0 && entries[i - 1].name == entries[i].name)
+			return rv_runtime_error(str("Shaders \"", files[i - 1].name, "\" and \"", files[i].name, "\" have the same name hash"));
+		entries[i].source = files[i].source;
+		entries[i].nameOffset = (u32)offset;
+		entries[i].nameSize = (u32)files[i].name.size();
+		offset += files[i].name.size() + 1;
+	}
+	for (size_t i = 0; i < files.size(); ++i)
+	{
+		offset = align(offset);
+		entries[i].codeOffset = offset;
+		entries[i].codeSize = files[i].code.size();
+		offset += files[i].code.size();
+	}
+
+	// Written next to the old archive first, so a failed write can't leave a half written archive behind
+	std::filesystem::path temp = path;
+	temp += ".tmp";
+	{
+		std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+		if (!out.is_open())
+			return rv_runtime_error(str("Unable to write shader archive \"", temp.string(), "\""));
+
+		u64 position = 0;
+		auto write = [&out, &position](const void* data, u64 size) {
+			out.write(reinterpret_cast<const char*>(data), size);
+			position += size;
+		};
+		write(&header, sizeof(header));
+		write(entries.data(), sizeof(Entry) * entries.size());
+		for (const auto& f : files)
+			write(f.name.c_str(), f.name.size() + 1);
+		for (size_t i = 0; i < files.size(); ++i)
+		{
+			static constexpr u8 padding[code_alignment] = {};
+			write(padding, entries[i].codeOffset - position);
+			write(files[i].code.data(), files[i].code.size());
+		}
+		if (!out)
+			return rv_runtime_error(str("Unable to write shader archive \"", temp.string(), "\""));
+	}
+
+	std::error_code error;
+	std::filesystem::rename(temp, path, error);
+	if (error)
+		return rv_runtime_error(str("Unable to replace shader archive \"", path.string(), "\": ", error.message()));
+	return result;
+}
+
+const rv::ShaderArchive::Entry* rv::ShaderArchive::Find(const char* name) const
+{
+	return Find(HashName(name));
+}
+
+const rv::ShaderArchive::Entry* rv::ShaderArchive::Find(u64 name) const
+{
+	const Entry* end = entries + count;
+	const Entry* entry = std::lower_bound(entries, end, name, [](const Entry& e, u64 n) { return e.name < n; });
+	return (entry != end && entry->name == name) ? entry : nullptr;
+}
+
+const char* rv::ShaderArchive::Name(const Entry& entry) const
+{
+	return reinterpret_cast<const char*>(file.data + entry.nameOffset);
+}
+
+const rv::u8* rv::ShaderArchive::Code(const Entry& entry) const
+{
+	return file.data + entry.codeOffset;
+}
+
+rv::Result rv::ShaderArchive::CreateShader(Shader& shader, const Device& device, const Entry& entry) const
+{
+	return Shader::Create(shader, device, Code(entry), entry.codeSize, Shader::GetShaderTypeFromFile(Name(entry)));
+}
+
+rv::u64 rv::ShaderArchive::HashName(const char* name)
+{
+	// Hashed as a C string, like Identifier does
+	const std::string normalized = Shader::NormalizeName(name);
+	return hash64(normalized.c_str());
+}
+
+rv::u64 rv::ShaderArchive::HashSource(const void* source, u64 size)
+{
+	return detail::fnv1a<u64>(reinterpret_cast<const u8*>(source), size);
+}
@@ -0,0 +1,457 @@
+#include "Engine/Graphics/ShaderReflection.h"
+#include "Engine/Graphics/Vertex.h"
+#include "Engine/Utility/Error.h"
+#include <algorithm>
+
+namespace spv
+{
+	static constexpr rv::u32 magic = 0x07230203;
+	static constexpr rv::u32 header_size = 5;
+
+	enum Op : rv::u32
+	{
+		OpEntryPoint = 15,
+		OpTypeBool = 20,
+		OpTypeInt = 21,
+		OpTypeFloat = 22,
+		OpTypeVector = 23,
+		OpTypeMatrix = 24,
+		OpTypeImage = 25,
+		OpTypeSampler = 26,
+		OpTypeSampledImage = 27,
+		OpTypeArray = 28,
+		OpTypeRuntimeArray = 29,
+		OpTypeStruct = 30,
+		OpTypePointer = 32,
+		OpConstant = 43,
+		OpVariable = 59,
+		OpDecorate = 71,
+		OpMemberDecorate = 72,
+		OpTypeAccelerationStructureKHR = 5341
+	};
+
+	enum Decoration : rv::u32
+	{
+		Block = 2,
+		BufferBlock = 3,
+		ArrayStride = 6,
+		MatrixStride = 7,
+		BuiltIn = 11,
+		Location = 30,
+		Binding = 33,
+		DescriptorSet = 34,
+		Offset = 35
+	};
+
+	enum StorageClass : rv::u32
+	{
+		UniformConstant = 0,
+		Input = 1,
+		Uniform = 2,
+		PushConstant = 9,
+		StorageBuffer = 12
+	};
+
+	enum Dim : rv::u32
+	{
+		DimBuffer = 5,
+		DimSubpassData = 6
+	};
+
+	// What the module says about one result id
+	struct Id
+	{
+		// The instruction that defines the id, nullptr when it isn't defined by a declaration
+		const rv::u32* op = nullptr;
+		rv::u32 set = 0;
+		rv::u32 binding = 0;
+		rv::u32 location = 0;
+		rv::u32 arrayStride = 0;
+		bool hasBinding = false;
+		bool hasLocation = false;
+		bool builtIn = false;
+		bool bufferBlock = false;
+		std::vector<rv::u32> memberOffsets;
+		std::vector<rv::u32> memberStrides;
+
+		rv::u32 opcode() const { return op ? op[0] & 0xFFFF : 0; }
+		rv::u32 words() const { return op ? op[0] >> 16 : 0; }
+	};
+
+	class Module
+	{
+	public:
+		std::vector<Id> ids;
+
+		const Id* get(rv::u32 id) const
+		{
+			return id < ids.size() && ids[id].op ? &ids[id] : nullptr;
+		}
+
+		const Id* type(rv::u32 id, rv::u32 opcode) const
+		{
+			const Id* t = get(id);
+			return t && t->opcode() == opcode ? t : nullptr;
+		}
+
+		// The value of an integer constant, used for array lengths
+		bool constant(rv::u32 id, rv::u32& value) const
+		{
+			const Id* c = get(id);
+			if (!c || c->opcode() != spv::OpConstant || c->words() < 4)
+				return false;
+			value = c->op[3];
+			return true;
+		}
+
+		// Strips arrays off the type, multiplying their lengths into count
+		const Id* element(rv::u32 id, rv::u32& count) const
+		{
+			const Id* t = get(id);
+			count = 1;
+			for (rv::u32 depth = 0; t && depth < 16; ++depth)
+			{
+				rv::u32 length = 0;
+				if (t->opcode() == spv::OpTypeArray && constant(t->op[3], length))
+					count *= length;
+				else if (t->opcode() == spv::OpTypeRuntimeArray)
+					count = 0;
+				else
+					return t;
+				t = get(t->op[2]);
+			}
+			return nullptr;
+		}
+
+		// Byte size of a type as laid out in a block, 0 if it can't be sized
+		rv::u32 size(rv::u32 id, rv::u32 matrixStride = 0, rv::u32 depth = 0) const
+		{
+			const Id* t = get(id);
+			if (!t || depth > 16)
+				return 0;
+			switch (t->opcode())
+			{
+				case spv::OpTypeBool:
+					return 4;
+				case spv::OpTypeInt:
+				case spv::OpTypeFloat:
+					return t->op[2] / 8;
+				case spv::OpTypeVector:
+					return t->op[3] * size(t->op[2], 0, depth + 1);
+				case spv::OpTypeMatrix:
+					return t->op[3] * (matrixStride ? matrixStride : size(t->op[2], 0, depth + 1));
+				case spv::OpTypePointer:
+					return 8;
+				case spv::OpTypeArray:
+				{
+					rv::u32 length = 0;
+					if (!constant(t->op[3], length))
+						return 0;
+					return length * (t->arrayStride ? t->arrayStride : size(t->op[2], 0, depth + 1));
+				}
+				case spv::OpTypeStruct:
+				{
+					rv::u32 end = 0;
+					const rv::u32 members = t->words() - 2;
+					for (rv::u32 m = 0; m < members && m < t->memberOffsets.size(); ++m)
+						end = std::max(end, t->memberOffsets[m] + size(t->op[2 + m], t->memberStrides[m], depth + 1));
+					return end;
+				}
+				default:
+					return 0;
+			}
+		}
+
+		// Format of a vertex input and the number of locations it takes up
+		VkFormat format(rv::u32 id, rv::u32& locations) const
+		{
+			static constexpr VkFormat floats[] = { VK_FORMAT_R32_SFLOAT, VK_FORMAT_R32G32_SFLOAT, VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32B32A32_SFLOAT };
+			static constexpr VkFormat doubles[] = { VK_FORMAT_R64_SFLOAT, VK_FORMAT_R64G64_SFLOAT, VK_FORMAT_R64G64B64_SFLOAT, VK_FORMAT_R64G64B64A64_SFLOAT };
+			static constexpr VkFormat sints[] = { VK_FORMAT_R32_SINT, VK_FORMAT_R32G32_SINT, VK_FORMAT_R32G32B32_SINT, VK_FORMAT_R32G32B32A32_SINT };
+			static constexpr VkFormat uints[] = { VK_FORMAT_R32_UINT, VK_FORMAT_R32G32_UINT, VK_FORMAT_R32G32B32_UINT, VK_FORMAT_R32G32B32A32_UINT };
+
+			locations = 1;
+			const Id* t = get(id);
+			if (t && t->opcode() == spv::OpTypeMatrix)
+			{
+				locations = t->op[3];
+				t = get(t->op[2]);
+			}
+
+			rv::u32 components = 1;
+			if (t && t->opcode() == spv::OpTypeVector)
+			{
+				components = t->op[3];
+				t = get(t->op[2]);
+			}
+			if (!t || components < 1 || components > 4 || locations < 1 || locations > 4)
+				return VK_FORMAT_UNDEFINED;
+
+			if (t->opcode() == spv::OpTypeFloat && t->op[2] == 32)
+				return floats[components - 1];
+			if (t->opcode() == spv::OpTypeFloat && t->op[2] == 64)
+				return doubles[components - 1];
+			if (t->opcode() == spv::OpTypeInt && t->op[2] == 32)
+				return t->op[3] ? sints[components - 1] : uints[components - 1];
+			return VK_FORMAT_UNDEFINED;
+		}
+
+		VkDescriptorType descriptor(const Id& t, rv::u32 storage) const
+		{
+			switch (t.opcode())
+			{
+				case spv::OpTypeSampler:
+					return VK_DESCRIPTOR_TYPE_SAMPLER;
+				case spv::OpTypeSampledImage:
+				{
+					const Id* image = type(t.op[2], spv::OpTypeImage);
+					if (image && image->op[3] == spv::DimBuffer)
+						return VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+					return VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+				}
+				case spv::OpTypeImage:
+					if (t.op[3] == spv::DimSubpassData)
+						return VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+					if (t.op[3] == spv::DimBuffer)
+						return t.op[7] == 2 ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+					return t.op[7] == 2 ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+				case spv::OpTypeAccelerationStructureKHR:
+					return VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR;
+				case spv::OpTypeStruct:
+					// Older modules declare storage buffers as Uniform blocks decorated with BufferBlock
+					if (storage == spv::StorageBuffer || (storage == spv::Uniform && t.bufferBlock))
+						return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+					if (storage == spv::Uniform)
+						return VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+					return VK_DESCRIPTOR_TYPE_MAX_ENUM;
+				default:
+					return VK_DESCRIPTOR_TYPE_MAX_ENUM;
+			}
+		}
+	};
+
+	// Minimum word count of the declarations that are read, so the operands can be indexed without checks
+	static rv::u32 min_words(rv::u32 opcode)
+	{
+		switch (opcode)
+		{
+			case spv::OpTypeInt: return 4;
+			case spv::OpTypeFloat: return 3;
+			case spv::OpTypeVector: return 4;
+			case spv::OpTypeMatrix: return 4;
+			case spv::OpTypeImage: return 9;
+			case spv::OpTypeSampledImage: return 3;
+			case spv::OpTypeArray: return 4;
+			case spv::OpTypeRuntimeArray: return 3;
+			case spv::OpTypePointer: return 4;
+			case spv::OpConstant: return 3;
+			case spv::OpVariable: return 4;
+			default: return 2;
+		}
+	}
+
+	static VkShaderStageFlagBits stage_from_model(rv::u32 model)
+	{
+		switch (model)
+		{
+			case 0: return VK_SHADER_STAGE_VERTEX_BIT;
+			case 1: return VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
+			case 2: return VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+			case 3: return VK_SHADER_STAGE_GEOMETRY_BIT;
+			case 4: return VK_SHADER_STAGE_FRAGMENT_BIT;
+			case 5: return VK_SHADER_STAGE_COMPUTE_BIT;
+			case 5267: return VK_SHADER_STAGE_TASK_BIT_NV;
+			case 5268: return VK_SHADER_STAGE_MESH_BIT_NV;
+			case 5313: return VK_SHADER_STAGE_RAYGEN_BIT_KHR;
+			case 5314: return VK_SHADER_STAGE_INTERSECTION_BIT_KHR;
+			case 5315: return VK_SHADER_STAGE_ANY_HIT_BIT_KHR;
+			case 5316: return VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR;
+			case 5317: return VK_SHADER_STAGE_MISS_BIT_KHR;
+			case 5318: return VK_SHADER_STAGE_CALLABLE_BIT_KHR;
+			default: return VK_SHADER_STAGE_FLAG_BITS_MAX_ENUM;
+		}
+	}
+}
+
+rv::Result rv::ShaderReflection::Create(ShaderReflection& reflection, const void* code, u64 size)
+{
+	reflection.Clear();
+	rv_result;
+	rif_check_info(code && size % sizeof(u32) == 0 && size / sizeof(u32) >= spv::header_size, "Invalid SPIR-V code");
+
+	const u32* words = reinterpret_cast<const u32*>(code);
+	const u64 nWords = size / sizeof(u32);
+	rif_check_info(words[0] == spv::magic, "Invalid SPIR-V magic, the module might have the wrong endianness");
+	// The bound is only a claim of the module, cap it so a corrupt header can't make it allocate gigabytes
+	rif_check_info(words[3] <= nWords, "Invalid SPIR-V id bound");
+
+	spv::Module module;
+	module.ids.resize(words[3]);
+	std::vector<u32> variables;
+
+	for (u64 i = spv::header_size; i < nWords; )
+	{
+		const u32* op = words + i;
+		const u32 count = op[0] >> 16;
+		const u32 opcode = op[0] & 0xFFFF;
+		rif_check_info(count && i + count <= nWords, "Invalid SPIR-V instruction");
+		i += count;
+		if (count < spv::min_words(opcode))
+			continue;
+
+		switch (opcode)
+		{
+			case spv::OpEntryPoint:
+				// Modules with several entry points are reflected as the first one
+				if (reflection.stage == VK_SHADER_STAGE_FLAG_BITS_MAX_ENUM)
+					reflection.stage = spv::stage_from_model(op[1]);
+				break;
+
+			case spv::OpDecorate:
+			{
+				if (count < 3 || op[1] >= module.ids.size())
+					break;
+				spv::Id& id = module.ids[op[1]];
+				const bool literal = count >= 4;
+				switch (op[2])
+				{
+					case spv::BufferBlock: id.bufferBlock = true; break;
+					case spv::BuiltIn: id.builtIn = true; break;
+					case spv::ArrayStride: if (literal) id.arrayStride = op[3]; break;
+					case spv::Location: if (literal) { id.location = op[3]; id.hasLocation = true; } break;
+					case spv::Binding: if (literal) { id.binding = op[3]; id.hasBinding = true; } break;
+					case spv::DescriptorSet: if (literal) id.set = op[3]; break;
+				}
+				break;
+			}
+
+			case spv::OpMemberDecorate:
+			{
+				if (count < 5 || op[1] >= module.ids.size() || (op[3] != spv::Offset && op[3] != spv::MatrixStride) || op[2] >= 0xFFFF)
+					break;
+				spv::Id& id = module.ids[op[1]];
+				if (op[2] >= id.memberOffsets.size())
+				{
+					id.memberOffsets.resize(op[2] + 1);
+					id.memberStrides.resize(op[2] + 1);
+				}
+				(op[3] == spv::Offset ? id.memberOffsets : id.memberStrides)[op[2]] = op[4];
+				break;
+			}
+
+			case spv::OpTypeBool:
+			case spv::OpTypeInt:
+			case spv::OpTypeFloat:
+			case spv::OpTypeVector:
+			case spv::OpTypeMatrix:
+			case spv::OpTypeImage:
+			case spv::OpTypeSampler:
+			case spv::OpTypeSampledImage:
+			case spv::OpTypeArray:
+			case spv::OpTypeRuntimeArray:
+			case spv::OpTypeStruct:
+			case spv::OpTypePointer:
+			case spv::OpTypeAccelerationStructureKHR:
+				rif_check_info(op[1] < module.ids.size(), "Invalid SPIR-V id");
+				module.ids[op[1]].op = op;
+				break;
+
+			case spv::OpConstant:
+			case spv::OpVariable:
+				rif_check_info(op[2] < module.ids.size(), "Invalid SPIR-V id");
+				module.ids[op[2]].op = op;
+				if (opcode == spv::OpVariable)
+					variables.push_back(op[2]);
+				break;
+		}
+	}
+	rif_check_info(reflection.stage != VK_SHADER_STAGE_FLAG_BITS_MAX_ENUM, "SPIR-V module has no supported entry point");
+
+	for (const u32 v : variables)
+	{
+		const spv::Id& variable = module.ids[v];
+		const u32 storage = variable.op[3];
+		const spv::Id* pointer = module.type(variable.op[1], spv::OpTypePointer);
+		rif_check_info(pointer, "Invalid SPIR-V variable type");
+
+		switch (storage)
+		{
+			case spv::UniformConstant:
+			case spv::Uniform:
+			case spv::StorageBuffer:
+			{
+				if (!variable.hasBinding)
+					break;
+				Binding binding;
+				binding.set = variable.set;
+				binding.binding = variable.binding;
+				const spv::Id* type = module.element(pointer->op[3], binding.count);
+				rif_check_info(type, "Invalid SPIR-V descriptor type");
+				binding.type = module.descriptor(*type, storage);
+				rif_check_info(binding.type != VK_DESCRIPTOR_TYPE_MAX_ENUM, "Unsupported SPIR-V descriptor type");
+				reflection.bindings.push_back(binding);
+				break;
+			}
+
+			case spv::PushConstant:
+			{
+				const spv::Id* block = module.type(pointer->op[3], spv::OpTypeStruct);
+				rif_check_info(block, "Invalid SPIR-V push constant block");
+				VkPushConstantRange range{};
+				range.stageFlags = reflection.stage;
+				range.offset = block->memberOffsets.empty() ? 0 : *std::min_element(block->memberOffsets.begin(), block->memberOffsets.end());
+				range.size = module.size(pointer->op[3]) - range.offset;
+				rif_check_info(range.size, "Unsupported SPIR-V push constant block");
+				reflection.pushConstants.push_back(range);
+				break;
+			}
+
+			case spv::Input:
+			{
+				if (reflection.stage != VK_SHADER_STAGE_VERTEX_BIT || variable.builtIn || !variable.hasLocation)
+					break;
+				u32 locations = 1;
+				const u32 type = pointer->op[3];
+				const VkFormat format = module.format(type, locations);
+				rif_check_info(format != VK_FORMAT_UNDEFINED, "Unsupported SPIR-V vertex input type");
+				for (u32 l = 0; l < locations; ++l)
+				{
+					VkVertexInputAttributeDescription attribute{};
+					attribute.binding = 0;
+					attribute.location = variable.location + l;
+					attribute.format = format;
+					reflection.vertexAttributes.push_back(attribute);
+				}
+				break;
+			}
+		}
+	}
+
+	std::sort(reflection.bindings.begin(), reflection.bindings.end(), [](const Binding& a, const Binding& b) {
+		return a.set == b.set ? a.binding < b.binding : a.set < b.set;
+	});
+
+	std::sort(reflection.vertexAttributes.begin(), reflection.vertexAttributes.end(), [](const VkVertexInputAttributeDescription& a, const VkVertexInputAttributeDescription& b) {
+		return a.location < b.location;
+	});
+	u32 offset = 0;
+	for (auto& attribute : reflection.vertexAttributes)
+	{
+		attribute.offset = offset;
+		offset += detail::GetFormatSize(attribute.format);
+	}
+	reflection.vertexBinding.binding = 0;
+	reflection.vertexBinding.stride = offset;
+	reflection.vertexBinding.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+	return result;
+}
+
+void rv::ShaderReflection::Clear()
+{
+	stage = VK_SHADER_STAGE_FLAG_BITS_MAX_ENUM;
+	bindings.clear();
+	pushConstants.clear();
+	vertexBinding = {};
+	vertexAttributes.clear();
+}
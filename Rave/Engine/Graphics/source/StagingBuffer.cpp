@@ -3,9 +3,10 @@
 
 rv::StagingBuffer::StagingBuffer(StagingBuffer&& rhs) noexcept
 	:
-	Buffer(std::move(rhs)),
-	copyCommand(std::move(rhs.copyCommand)),
-	manager(move(rhs.manager))
+	manager(move(rhs.manager)),
+	destination(move(rhs.destination)),
+	dstOffset(rhs.dstOffset),
+	bytes(std::move(rhs.bytes))
 {
 }
 
@@ -16,46 +17,46 @@ rv::StagingBuffer::~StagingBuffer()
 
 rv::StagingBuffer& rv::StagingBuffer::operator=(StagingBuffer&& rhs) noexcept
 {
-	detail::move_buffers<Buffer>(*this, rhs);
-	copyCommand = std::move(rhs.copyCommand);
 	manager = move(rhs.manager);
+	destination = move(rhs.destination);
+	dstOffset = rhs.dstOffset;
+	bytes = std::move(rhs.bytes);
 	return *this;
 }
 
 void rv::StagingBuffer::Release()
 {
-	Buffer::Release();
-	copyCommand.Release();
 	manager = nullptr;
+	destination = VK_NULL_HANDLE;
+	bytes.clear();
 }
 
-rv::Result rv::StagingBuffer::Create(StagingBuffer& staging, const StagingBufferManager& manager, const Buffer& destination, const void* data, u64 size, bool once, u64 srcOffset, u64 dstOffset)
+rv::Result rv::StagingBuffer::Create(StagingBuffer& staging, StagingBufferManager& manager, const Buffer& destination, const void* data, u64 size, u64 srcOffset, u64 dstOffset)
 {
 	staging.Release();
 	rv_result;
+	rif_assert(data);
 
 	staging.manager = &manager;
-
-	rv_rif(Buffer::Create(staging, *manager.allocator, data, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_CPU_ONLY));
-	rv_rif(CommandBuffer::Create(staging.copyCommand, *manager.device, manager.pool));
-	rv_rif(staging.copyCommand.Begin());
-	staging.copyCommand.CopyBuffers(staging, destination, size, srcOffset, dstOffset);
-	rv_rif(staging.copyCommand.End());
+	staging.destination = destination.buffer;
+	staging.dstOffset = dstOffset;
+	staging.bytes.assign((const u8*)data + srcOffset, (const u8*)data + srcOffset + size);
 	return result;
 }
 
-rv::Result rv::StagingBuffer::Copy() const
+rv::Result rv::StagingBuffer::Copy(bool wait) const
 {
-	rv_result;
-	Fence fence;
-	rv_rif(Fence::Create(fence, *copyCommand.device));
-	rv_rif(copyCommand.Submit(manager->transferQueue, &fence));
-	return fence.Wait();
+	return Upload(bytes.data(), bytes.size(), wait);
 }
 
-rv::Result rv::StagingBuffer::Copy(const Fence& fence) const
+rv::Result rv::StagingBuffer::Upload(const void* source, u64 size, bool wait) const
 {
-	return copyCommand.Submit(manager->transferQueue, &fence);
+	rv_result;
+	rif_assert(manager);
+	rv_rif(manager->Upload(destination, source, size, dstOffset));
+	if (wait && !manager->Batching())
+		return manager->Wait();
+	return result;
 }
 
 rv::StagingBufferManager::StagingBufferManager(StagingBufferManager&& rhs) noexcept
@@ -63,31 +64,285 @@ rv::StagingBufferManager::StagingBufferManager(StagingBufferManager&& rhs) noexc
 	pool(std::move(rhs.pool)),
 	allocator(move(rhs.allocator)),
 	device(move(rhs.device)),
-	transferQueue(rhs.transferQueue)
+	transferQueue(rhs.transferQueue),
+	ring(std::move(rhs.ring)),
+	mapped(move(rhs.mapped)),
+	capacity(rhs.capacity),
+	head(rhs.head),
+	tail(rhs.tail),
+	pending(std::move(rhs.pending)),
+	available(std::move(rhs.available)),
+	current(std::move(rhs.current)),
+	recording(rhs.recording),
+	depth(rhs.depth),
+	batch(rhs.batch),
+	nextToken(rhs.nextToken)
+{
+}
+
+rv::StagingBufferManager::~StagingBufferManager()
 {
+	Release();
 }
 
 rv::StagingBufferManager& rv::StagingBufferManager::operator=(StagingBufferManager&& rhs) noexcept
 {
+	// Waits for the uploads still reading the ring being replaced, then unmaps it
+	Release();
 	pool = std::move(rhs.pool);
 	allocator = move(rhs.allocator);
 	device = move(rhs.device);
 	transferQueue = rhs.transferQueue;
+	ring = std::move(rhs.ring);
+	mapped = move(rhs.mapped);
+	capacity = rhs.capacity;
+	head = rhs.head;
+	tail = rhs.tail;
+	pending = std::move(rhs.pending);
+	available = std::move(rhs.available);
+	current = std::move(rhs.current);
+	recording = rhs.recording;
+	depth = rhs.depth;
+	batch = rhs.batch;
+	nextToken = rhs.nextToken;
 	return *this;
 }
 
 void rv::StagingBufferManager::Release()
 {
+	if (device)
+	{
+		if (recording)
+			Flush();
+		Wait();
+	}
+	pending.clear();
+	available.clear();
+	current.command.Release();
+	current.fence.Release();
+	current.dedicated.clear();
+	recording = false;
+	depth = 0;
+	if (mapped)
+	{
+		vmaUnmapMemory(ring.allocation.Allocator(), ring.allocation.allocation);
+		mapped = nullptr;
+	}
+	ring.Release();
 	pool.Release();
 	allocator = nullptr;
 	device = nullptr;
 	transferQueue.Release();
+	capacity = 0;
+	head = 0;
+	tail = 0;
 }
 
-rv::Result rv::StagingBufferManager::Create(StagingBufferManager& manager, const Device& device, const MemoryAllocator& allocator, const Queue& transferQueue)
+rv::Result rv::StagingBufferManager::Create(StagingBufferManager& manager, const Device& device, const MemoryAllocator& allocator, const Queue& transferQueue, u64 size)
 {
+	manager.Release();
+	rv_result;
+
 	manager.device = &device;
 	manager.allocator = &allocator;
 	manager.transferQueue = transferQueue;
-	return CommandPool::Create(manager.pool, device, transferQueue.family);
+	manager.capacity = (size + alignment - 1) & ~(alignment - 1);
+	rv_rif(CommandPool::Create(manager.pool, device, transferQueue.family, true));
+	rv_rif(Buffer::Create(manager.ring, allocator, manager.capacity, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_CPU_ONLY));
+
+	void* map = nullptr;
+	rif_try_vkr(vmaMapMemory(allocator.allocator, manager.ring.allocation.allocation, &map));
+	manager.mapped = (u8*)map;
+	return result;
+}
+
+rv::Result rv::StagingBufferManager::Upload(VkBuffer destination, const void* data, u64 size, u64 dstOffset)
+{
+	rv_result;
+	rif_assert(data);
+	rif_assert(size);
+	rif_assert(destination);
+
+	if (size > capacity)
+		return UploadDedicated(destination, data, size, dstOffset);
+
+	UploadToken token;
+	BeginBatch();
+	u64 offset = 0;
+	result = Reserve(size, offset);
+	if (result.succeeded())
+	{
+		memcpy(mapped + offset, data, size);
+		result = Record(ring.buffer, destination, size, offset, dstOffset);
+	}
+	Result submit = SubmitBatch(token);
+	return result.failed() ? result : submit;
+}
+
+rv::Result rv::StagingBufferManager::Upload(const Buffer& destination, const void* data, u64 size, u64 dstOffset)
+{
+	return Upload(destination.buffer, data, size, dstOffset);
+}
+
+void rv::StagingBufferManager::BeginBatch()
+{
+	if (depth++ == 0)
+		batch = nextToken++;
+}
+
+rv::Result rv::StagingBufferManager::SubmitBatch(UploadToken& token)
+{
+	rv_result;
+	rif_assert(depth);
+	token = batch;
+	if (--depth == 0)
+		return Flush();
+	return result;
+}
+
+rv::Result rv::StagingBufferManager::EndBatch()
+{
+	rv_result;
+	UploadToken token;
+	rv_rif(SubmitBatch(token));
+	if (depth == 0)
+		return Wait(token);
+	return result;
+}
+
+bool rv::StagingBufferManager::Batching() const
+{
+	return depth;
+}
+
+rv::Result rv::StagingBufferManager::Wait()
+{
+	rv_result;
+	for (const Submission& submission : pending)
+		rv_rif(submission.fence.Wait());
+	Reclaim();
+	return result;
+}
+
+rv::Result rv::StagingBufferManager::Wait(UploadToken token)
+{
+	rv_result;
+	rif_assert_info(!depth || token < batch, "Waiting on a batch that hasn't been submitted");
+	for (const Submission& submission : pending)
+	{
+		if (submission.token > token)
+			break;
+		rv_rif(submission.fence.Wait());
+	}
+	Reclaim();
+	return result;
+}
+
+bool rv::StagingBufferManager::Finished(UploadToken token)
+{
+	Reclaim();
+	if (depth && token >= batch)
+		return false;
+	return pending.empty() || pending.front().token > token;
+}
+
+void rv::StagingBufferManager::Reclaim()
+{
+	while (!pending.empty() && vkGetFenceStatus(device->device, pending.front().fence.fence) == VK_SUCCESS)
+	{
+		tail = pending.front().end;
+		pending.front().dedicated.clear();
+		available.push_back(std::move(pending.front()));
+		pending.pop_front();
+	}
+	// the open batch still owns everything between tail and head
+	if (pending.empty() && !recording)
+		head = tail = 0;
+}
+
+rv::Result rv::StagingBufferManager::Reserve(u64 size, u64& offset)
+{
+	rv_result;
+	size = (size + alignment - 1) & ~(alignment - 1);
+	rif_assert(size <= capacity);
+
+	while (true)
+	{
+		Reclaim();
+		const u64 position = head % capacity;
+		const u64 padding = position + size > capacity ? capacity - position : 0;
+		if (head + padding + size - tail <= capacity)
+		{
+			offset = (head + padding) % capacity;
+			head += padding + size;
+			return result;
+		}
+		// the open batch fills the ring by itself, submit what it has recorded so far
+		if (pending.empty())
+			rv_rif(Flush());
+		rif_assert(!pending.empty());
+		rv_rif(pending.front().fence.Wait());
+	}
+}
+
+rv::Result rv::StagingBufferManager::NextSubmission(Submission& submission)
+{
+	rv_result;
+	if (!available.empty())
+	{
+		submission = std::move(available.back());
+		available.pop_back();
+		return result;
+	}
+	rv_rif(CommandBuffer::Create(submission.command, *device, pool));
+	return Fence::Create(submission.fence, *device, true);
+}
+
+rv::Result rv::StagingBufferManager::Record(VkBuffer source, VkBuffer destination, u64 size, u64 srcOffset, u64 dstOffset)
+{
+	rv_result;
+	if (!recording)
+	{
+		if (!current.fence.fence)
+			rv_rif(NextSubmission(current));
+		rv_rif(current.command.Begin(true));
+		recording = true;
+	}
+	VkBufferCopy region{};
+	region.srcOffset = srcOffset;
+	region.dstOffset = dstOffset;
+	region.size = size;
+	vkCmdCopyBuffer(current.command.buffer, source, destination, 1, &region);
+	return result;
+}
+
+rv::Result rv::StagingBufferManager::Flush()
+{
+	rv_result;
+	if (!recording)
+		return result;
+	recording = false;
+	rv_rif(current.command.End());
+	rv_rif(current.fence.Reset());
+	rv_rif(current.command.Submit(transferQueue, &current.fence));
+	current.end = head;
+	current.token = batch;
+	pending.push_back(std::move(current));
+	return result;
+}
+
+rv::Result rv::StagingBufferManager::UploadDedicated(VkBuffer destination, const void* data, u64 size, u64 dstOffset)
+{
+	rv_result;
+	Buffer staging;
+	rv_rif(Buffer::Create(staging, *allocator, data, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_CPU_ONLY));
+
+	// Goes into the open batch like a ring upload, the current submission owns the buffer until its fence signals
+	UploadToken token;
+	BeginBatch();
+	result = Record(staging.buffer, destination, size, 0, dstOffset);
+	if (result.succeeded())
+		current.dedicated.push_back(std::move(staging));
+	Result submit = SubmitBatch(token);
+	return result.failed() ? result : submit;
 }
@@ -159,7 +159,11 @@ rv::Result rv::SwapChain::Present(u32 image, const Semaphore& wait, bool& resize
 	presentInfo.swapchainCount = 1;
 	presentInfo.pSwapchains = &swap;
 	presentInfo.pImageIndices = &image;
-	VkResult vkr = vkQueuePresentKHR(presentQueue.queue, &presentInfo);
+	VkResult vkr;
+	{
+		auto lock = presentQueue.Lock();
+		vkr = vkQueuePresentKHR(presentQueue.queue, &presentInfo);
+	}
 
 	if (vkr == VK_ERROR_OUT_OF_DATE_KHR || vkr == VK_SUBOPTIMAL_KHR)
 	{
@@ -0,0 +1,78 @@
+#include "Engine/Graphics/UniformArena.h"
+#include "Engine/Utility/Error.h"
+
+rv::UniformArena::UniformArena(UniformArena&& rhs) noexcept
+	:
+	buffer(std::move(rhs.buffer)),
+	mapped(move(rhs.mapped)),
+	elementSize(rhs.elementSize),
+	stride(rhs.stride),
+	capacity(rhs.capacity)
+{
+	rhs.capacity = 0;
+}
+
+rv::UniformArena::~UniformArena()
+{
+	Release();
+}
+
+rv::UniformArena& rv::UniformArena::operator=(UniformArena&& rhs) noexcept
+{
+	Release();
+	buffer = std::move(rhs.buffer);
+	mapped = move(rhs.mapped);
+	elementSize = rhs.elementSize;
+	stride = rhs.stride;
+	capacity = rhs.capacity;
+	rhs.capacity = 0;
+	return *this;
+}
+
+void rv::UniformArena::Release()
+{
+	if (mapped)
+	{
+		vmaUnmapMemory(buffer.allocation.Allocator(), buffer.allocation.allocation);
+		mapped = nullptr;
+	}
+	buffer.Release();
+	capacity = 0;
+}
+
+rv::Result rv::UniformArena::Create(UniformArena& arena, const Device& device, const MemoryAllocator& allocator, u64 elementSize, u32 capacity, VkBufferUsageFlags usage)
+{
+	arena.Release();
+	rv_result;
+	rif_assert(elementSize);
+	rif_assert(capacity);
+
+	u64 alignment = 1;
+	if (usage & VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT)
+		alignment = std::max<u64>(device.physical.properties.limits.minUniformBufferOffsetAlignment, 1);
+	arena.elementSize = elementSize;
+	arena.stride = (elementSize + alignment - 1) / alignment * alignment;
+	rv_rif(Buffer::Create(arena.buffer, allocator, arena.stride * capacity, usage, VMA_MEMORY_USAGE_CPU_TO_GPU));
+
+	void* map = nullptr;
+	rif_try_vkr(vmaMapMemory(allocator.allocator, arena.buffer.allocation.allocation, &map));
+	arena.mapped = (u8*)map;
+	arena.capacity = capacity;
+	return result;
+}
+
+void rv::UniformArena::Write(u32 slot, const void* data, u64 size)
+{
+	memcpy(mapped + slot * stride, data, std::min(size, elementSize));
+}
+
+rv::u32 rv::UniformArena::Offset(u32 slot) const
+{
+	return (u32)(slot * stride);
+}
+
+void rv::UniformArena::Flush() const
+{
+	if (mapped)
+		vmaFlushAllocation(buffer.allocation.Allocator(), buffer.allocation.allocation, 0, VK_WHOLE_SIZE);
+}
@@ -0,0 +1,162 @@
+#include "Engine/Graphics/UploadQueue.h"
+#include "Engine/Utility/Error.h"
+
+rv::UploadQueue::~UploadQueue()
+{
+	Release();
+}
+
+void rv::UploadQueue::Release()
+{
+	if (!worker.joinable())
+		return;
+	{
+		std::lock_guard guard(mutex);
+		running = false;
+	}
+	condition.notify_all();
+	worker.join();
+}
+
+rv::Result rv::UploadQueue::Create(UploadQueue& queue, const Device& device, const MemoryAllocator& allocator, const Queue& transferQueue, u64 size)
+{
+	queue.Release();
+	queue.running = true;
+
+	std::promise<Result> created;
+	std::future<Result> result = created.get_future();
+	queue.worker = std::thread(
+		[&queue, &device, &allocator, &transferQueue, size, created = std::move(created)]() mutable {
+			queue.Run(device, allocator, transferQueue, size, std::move(created));
+		}
+	);
+
+	Result r = result.get();
+	if (r.failed())
+		queue.Release();
+	return r;
+}
+
+std::future<rv::Result> rv::UploadQueue::Upload(const Buffer& destination, const void* data, u64 size, u64 dstOffset)
+{
+	Request request;
+	std::future<Result> future = request.promise.get_future();
+	if (!data || !size)
+	{
+		request.promise.set_value(success);
+		return future;
+	}
+
+	request.destination = destination.buffer;
+	request.data.assign((const u8*)data, (const u8*)data + size);
+	request.dstOffset = dstOffset;
+	{
+		std::lock_guard guard(mutex);
+		if (!running)
+		{
+			request.promise.set_value(rv_runtime_error("UploadQueue is not running"));
+			return future;
+		}
+		requests.push_back(std::move(request));
+		++outstanding;
+	}
+	condition.notify_one();
+	return future;
+}
+
+void rv::UploadQueue::Wait()
+{
+	std::unique_lock lock(mutex);
+	idle.wait(lock, [this]() { return outstanding == 0; });
+}
+
+size_t rv::UploadQueue::Outstanding() const
+{
+	std::lock_guard guard(mutex);
+	return outstanding;
+}
+
+void rv::UploadQueue::Run(const Device& device, const MemoryAllocator& allocator, const Queue& transferQueue, u64 size, std::promise<Result> created)
+{
+	{
+		Result result = StagingBufferManager::Create(manager, device, allocator, transferQueue, size);
+		const bool failed = result.failed();
+		created.set_value(result);
+		if (failed)
+			return;
+	}
+
+	std::vector<Request> submit;
+	while (true)
+	{
+		{
+			std::unique_lock lock(mutex);
+			auto wake = [this]() { return !running || !requests.empty(); };
+			if (batches.empty())
+				condition.wait(lock, wake);
+			else
+				condition.wait_for(lock, poll_interval, wake);
+
+			if (!running && requests.empty() && batches.empty())
+				break;
+			submit.swap(requests);
+		}
+
+		if (!submit.empty())
+			Submit(submit);
+
+		while (!batches.empty() && manager.Finished(batches.front().token))
+		{
+			Batch& batch = batches.front();
+			for (auto& promise : batch.promises)
+				promise.set_value(success);
+			Complete(batch.promises.size());
+			batches.pop_front();
+		}
+	}
+	manager.Release();
+}
+
+void rv::UploadQueue::Submit(std::vector<Request>& submit)
+{
+	Batch batch;
+	size_t failed = 0;
+	manager.BeginBatch();
+	for (Request& request : submit)
+	{
+		Result result = manager.Upload(request.destination, request.data.data(), request.data.size(), request.dstOffset);
+		if (result.failed())
+		{
+			request.promise.set_value(result);
+			++failed;
+		}
+		else
+		{
+			batch.promises.push_back(std::move(request.promise));
+		}
+	}
+	submit.clear();
+
+	Result result = manager.SubmitBatch(batch.token);
+	if (result.failed())
+	{
+		for (auto& promise : batch.promises)
+			promise.set_value(result);
+		failed += batch.promises.size();
+		batch.promises.clear();
+	}
+	Complete(failed);
+
+	if (!batch.promises.empty())
+		batches.push_back(std::move(batch));
+}
+
+void rv::UploadQueue::Complete(size_t count)
+{
+	if (count == 0)
+		return;
+	std::lock_guard guard(mutex);
+	outstanding -= count;
+	if (outstanding == 0)
+		idle.notify_all();
+}
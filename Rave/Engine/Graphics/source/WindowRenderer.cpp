@@ -1,16 +1,14 @@
 #include "Engine/Graphics/WindowRenderer.h"
-#include "Engine/Graphics/GraphicsHelper.h"
 #include "Engine/Utility/Error.h"
+#include "Engine/Utility/PerformanceLogger.h"
 #include "Engine/Utility/String.h"
 #include "Engine/Core/Logger.h"
 #include "Engine/Core/Engine.h"
 
 #ifdef RV_DEBUG
 #	define check_debug()		rv_rif(engine->graphics.debug.Check())
-#	define check_debug_static()	rv_rif(renderer.engine->graphics.debug.Check())
 #else
 #	define check_debug()
-#	define check_debug_static()
 #endif
 
 rv::WindowRenderer::~WindowRenderer()
@@ -27,8 +25,7 @@ rv::Result rv::WindowRenderer::Create(WindowRenderer& renderer, Engine& engine,
 	renderer.background = background;
 	renderer.swapPreferences = preferences;
 
-	rv_rif(CommandPool::CreateGraphics(renderer.drawPool, engine.graphics.device, true));
-	check_debug_static();
+	rv_rif(renderer.CreateCommandPools());
 
 	rv_rif(SwapChain::SetFullScreenFunctions(engine.graphics.instance));
 
@@ -54,40 +51,6 @@ rv::Result rv::WindowRenderer::Create(WindowRenderer& renderer, Engine& engine,
 	return Create(renderer, engine, background, window, swap);
 }
 
-rv::Result rv::WindowRenderer::GetPipeline(FullPipeline*& pipeline, const PipelineLayoutDescriptor& layout)
-{
-	rv_result;
-	rif_assert(engine);
-
-	pipeline = GetCachedPipeline(layout);
-	if (pipeline)
-		return success;
-	
-	result = PrepNewPipeline(pipeline, layout);
-	if (result.failed())
-	{
-		pipeline = nullptr;
-		return result;
-	}
-
-	pipeline->layout.SetSize(window.Size());
-	pipeline->layout.pass = colorPass.pass;
-
-	result = FullPipeline::Create(*pipeline, engine->graphics.device);
-	if (result.failed())
-		pipeline = nullptr;
-
-	check_debug();
-
-	return result;
-}
-
-rv::Result rv::WindowRenderer::AddPipeline(const PipelineLayoutDescriptor& layout)
-{
-	FullPipeline* pipeline;
-	return GetPipeline(pipeline, layout);
-}
-
 rv::Result rv::WindowRenderer::SetVSync(bool vsync)
 {
 	if (vsync != (swap.presentMode == VK_PRESENT_MODE_FIFO_KHR))
@@ -118,6 +81,7 @@ rv::Result rv::WindowRenderer::ToggleFullScreen()
 
 rv::Result rv::WindowRenderer::Render()
 {
+	rv_performance_scope("WindowRenderer::Render");
 	if (window.Minimized() || window.Size().height <= 0)
 		return success;
 	Result result;
@@ -134,19 +98,13 @@ rv::Result rv::WindowRenderer::Render()
 	if (resized)
 		return Resize();
 
-	for (auto it = drawCommands[image].begin(); it < drawCommands[image].end() - 1; ++it)
-	{
-		const CommandBuffer& draw = *it;
-		Result r = frames[currentFrame].Render(draw);
-		if (r.severity() > result.severity())
-		{
-			result = r;
-			if (result.fatal())
-				return result;
-		}
-	}
-	if (!drawCommands.empty())
-		frames[currentFrame].RenderLast(drawCommands[image].back());
+	// Start waited for the last frame that drew this image, its commands can be recorded again
+	rv_rif(PrepareImage(image));
+	UpdateDrawables(image);
+
+	result = frames[currentFrame].Render(drawCommands[image]);
+	if (result.fatal())
+		return result;
 	Result r = frames[currentFrame].End(resized);
 	check_debug();
 	if (resized)
@@ -161,43 +119,6 @@ rv::Result rv::WindowRenderer::Wait() const
 	return Frame::Wait(engine->graphics.device, frames);
 }
 
-rv::Result rv::WindowRenderer::CreateShape(Shape& shape, const HeapBuffer<Vertex2>& vertices, const HeapBuffer<u16>& indices, const FColor& color)
-{
-	rv_result;
-	rv_rif(engine->graphics.CreateShape(shape, vertices, indices, color));
-	rv_rif(Shape::InitImageData(shape, engine->graphics, *this, engine->graphics.setAllocator, engine->graphics.manager, (u32)swap.images.size()));
-	return AddDrawable(shape);
-}
-
-rv::Result rv::WindowRenderer::CreateShape(Shape& shape, HeapBuffer<Vertex2>&& vertices, HeapBuffer<u16>&& indices, const FColor& color)
-{
-	rv_result;
-	rv_rif(engine->graphics.CreateShape(shape, std::move(vertices), std::move(indices), color));
-	rv_rif(Shape::InitImageData(shape, engine->graphics, *this, engine->graphics.setAllocator, engine->graphics.manager, (u32)swap.images.size()));
-	return AddDrawable(shape);
-}
-
-rv::Result rv::WindowRenderer::Record(const DrawableRecorder& recorder, CommandBuffer& draw, size_t index)
-{
-	rv_result;
-	rv_rif(draw.Begin());
-	draw.StartRenderPass(colorPass, frameBuffers[index], 0, window.Size());
-	draw.BindPipeline(recorder.pipeline->pipeline);
-	recorder.recordFunction(draw, engine->graphics, *this, recorder, (u32)index);
-	draw.EndRenderPass();
-	return draw.End();
-}
-
-rv::u32 rv::WindowRenderer::ImageCount() const
-{
-	return (u32)swap.images.size();
-}
-
-rv::u32 rv::WindowRenderer::CurrentImage() const
-{
-	return Optional<u32>::invalid_value;
-}
-
 rv::Result rv::WindowRenderer::Resize()
 {
 	if (window.Size().height <= 0)
@@ -212,56 +133,23 @@ rv::Result rv::WindowRenderer::Resize()
 	rv_rif(SwapChain::Create(swap, engine->graphics.instance, engine->graphics.device, window, swapPreferences));
 	check_debug();
 
-	if (!resized || oldFormat != swap.format.format)
-	{
-		RenderPassDescriptor color;
-		color.AddSubpass();
-		color.AddColorAttachment(0, swap.format.format);
-		color.AddColorDependency();
-		rv_rif(RenderPass::Create(colorPass, engine->graphics.device, color));
-		check_debug();
-		RenderPassDescriptor clear;
-		clear.AddSubpass();
-		clear.AddColorAttachment(0, swap.format.format, VK_ATTACHMENT_LOAD_OP_CLEAR);
-		clear.AddColorDependency();
-		rv_rif(RenderPass::Create(clearPass, engine->graphics.device, clear));
-		check_debug();
-	}
+	const bool newPasses = !resized || oldFormat != swap.format.format;
+	if (newPasses)
+		rv_rif(CreatePasses(swap.format.format, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR));
 
+	size = window.Size();
 	frameBuffers.resize(swap.images.size());
 	for (size_t i = 0; i < frameBuffers.size(); ++i)
-		rv_rif(FrameBuffer::Create(frameBuffers[i], engine->graphics.device, colorPass, window.Size(), swap.views[i]));
+		rv_rif(FrameBuffer::Create(frameBuffers[i], engine->graphics.device, colorPass, size, swap.views[i]));
 	check_debug();
+	rv_rif(AllocateDrawCommands());
 
-	drawCommands.resize(frameBuffers.size());
-	for (size_t i = 0; i < drawCommands.size(); ++i)
-	{
-		CommandBuffer& clear = resized ? drawCommands[i][0] : drawCommands[i].emplace_back();
-		if (!resized)
-			rv_rif(CommandBuffer::Create(clear, engine->graphics.device, drawPool));
-		else
-			rv_rif(clear.Reset());
-		rv_rif(clear.Begin());
-		clear.StartRenderPass(clearPass, frameBuffers[i], 0, window.Size(), background);
-		clear.EndRenderPass();
-		rv_rif(clear.End());
-	}
-
-	for (auto& pipeline : pipelines)
-	{
-		pipeline.second.layout.SetSize(window.Size());
-		pipeline.second.layout.pass = colorPass.pass;
-		rv_rif(Pipeline::Create(pipeline.second.pipeline, engine->graphics.device, pipeline.second.layout));
-	}
-
-	for (const auto& recorder : recorders)
-	{
-		for (size_t i = 0; i < drawCommands.size(); ++i)
-		{
-			CommandBuffer& draw = drawCommands[i][recorder.commandIndex];
-			rv_rif(Record(recorder, draw, i));
-		}
-	}
+	// The viewport is dynamic, the pipelines only depend on the render pass and therefore on the swap chain format
+	if (newPasses)
+		rv_rif(RebuildPipelines());
 
+	// The framebuffers and the viewport changed, so every image is recorded again before it is rendered.
+	// PrepareImage also creates the drawable data of images the new swap chain added.
+	Invalidate();
 	return result;
-}
+}
\ No newline at end of file
@@ -12,6 +12,7 @@
 #include "Engine/Graphics/Vulkan.h"
 #include "Engine/Graphics/Graphics.h"
 #include "Engine/Graphics/GraphicsHelper.h"
+#include "Engine/Graphics/OffscreenRenderer.h"
 
 #include "Engine/Utility/Hash.h"
 #include "Engine/Utility/Identifier.h"
@@ -1,8 +1,13 @@
 #pragma once
 #include "Engine/Utility/Identifier.h"
-#include <deque>
+#include "Engine/Utility/RingBuffer.h"
 #include <mutex>
 #include <memory>
+#include <array>
+#include <new>
+#include <cstddef>
+#include <span>
+#include <limits>
 
 namespace rv
 {
@@ -18,67 +23,190 @@ namespace rv
 	template<typename E>
 	concept EventConcept = requires { E::type_id; } && std::is_base_of_v<EventData, E>;
 
+	// Events that may be merged into a pending event of the same type, e.g. mouse movement
+	template<typename E>
+	concept CoalescableEvent = EventConcept<E> && requires(E& pending, const E& event) { E::Coalesce(pending, event); };
+
+
+	/*
+		Holds a copy of any event of up to max_size bytes by value, events never touch the heap.
+	*/
+	struct Event
+	{
+	public:
+		static constexpr size_t max_size = 64;
+
+		Event() = default;
+		Event(const Event& rhs);
+		Event(Event&& rhs) noexcept;
+		~Event();
+
+		Event& operator= (const Event& rhs);
+		Event& operator= (Event&& rhs) noexcept;
+
+		template<EventConcept E>
+		Event(const E& event)
+		{
+			static_assert(sizeof(E) <= max_size && alignof(E) <= alignof(std::max_align_t), "Event type too large to be stored inline");
+			new (data) E(event);
+			functions = &TypedFunctions<E>::functions;
+		}
+
+		operator bool() const;
+		bool Valid() const;
+		void Release();
+
+		template<typename E>			E& get()		{ return *std::launder(reinterpret_cast<E*>(data)); }
+		template<typename E>	const	E& get() const	{ return *std::launder(reinterpret_cast<const E*>(data)); }
+
+		Identifier ID() const;
+		bool IsType(const Identifier& type) const;
+		template<EventConcept E>
+		bool IsType() const
+		{ 
+			return IsType(E::type_id);
+		}
+
+	private:
+		struct Functions
+		{
+			void (*copy)(void* destination, const void* source);
+			void (*destroy)(void* event);
+			const EventData& (*base)(const void* event);
+		};
+
+		template<EventConcept E>
+		struct TypedFunctions
+		{
+			static constexpr Functions functions = {
+				[](void* destination, const void* source) { new (destination) E(*static_cast<const E*>(source)); },
+				[](void* event) { static_cast<E*>(event)->~E(); },
+				[](const void* event) -> const EventData& { return *static_cast<const E*>(event); }
+			};
+		};
+
+		const Functions* functions = nullptr;
+		alignas(std::max_align_t) unsigned char data[max_size];
+	};
 
+	enum EventOverflowPolicy
+	{
+		RV_EVENT_OVERFLOW_DROP,		// drop the new event and count it
+		RV_EVENT_OVERFLOW_BLOCK,	// wait until the listener made room
+	};
+
+	/*
+		Every listener owns a bounded lock-free ring of events stored by value,
+		posting never takes a lock or allocates. The mutex only guards listening and unlistening.
+		Listener slots come in blocks that are only freed with the queue, a full block gets a new one chained to it.
+
+		Types enabled with EnableCoalescing keep at most one pending event per listener. A newer event is merged
+		into it with E::Coalesce while it is still the newest event in the listener's ring, otherwise it is queued
+		by itself so no event overtakes another.
+	*/
 	class EventQueue
 	{
 	public:
-		EventQueue();
+		static constexpr size_t default_capacity = 1024;
+		static constexpr size_t listener_block_size = 16;
+		static constexpr size_t max_coalesced_types = 4;
+
+		EventQueue(size_t capacity = default_capacity, EventOverflowPolicy overflow = RV_EVENT_OVERFLOW_DROP);
 		~EventQueue();
 
 	protected:
-		void PostEvent(EventData* event);
-		template<EventConcept E>
-		void PostEvent(const E& event)
+		// Not thread safe, enable coalescing before any events are posted.
+		template<CoalescableEvent E>
+		bool EnableCoalescing()
 		{
-			PostEvent(new E(event));
+			return EnableCoalescing(E::type_id);
 		}
+
 		template<EventConcept E>
-		void PostEvent(E&& event)
+		void PostEvent(const E& event)
 		{
-			PostEvent(new E(std::move(event)));
+			if constexpr (CoalescableEvent<E>)
+			{
+				const u32 mailbox = FindMailbox(E::type_id);
+				if (mailbox != no_mailbox)
+					return PostEvent(Event(event), mailbox, [](Event& pending, const Event& event) { E::Coalesce(pending.get<E>(), event.get<E>()); });
+			}
+			PostEvent(Event(event));
 		}
 
 		template<EventConcept E, typename... Args>
 		void EmplaceEvent(const Args&... args)
 		{
-			PostEvent(new E(args...));
+			PostEvent<E>(E(args...));
 		}
 
 	private:
-		struct ListenerQueue
+		typedef void (*EventMergeFunction)(Event& pending, const Event& event);
+		static constexpr size_t no_position = std::numeric_limits<size_t>::max();
+
+		struct CoalescedEvent : public EventData
 		{
-			ListenerQueue() = default;
-			std::deque<std::unique_ptr<EventData>> events;
+			static constexpr Identifier type_id = Identifier("Coalesced Event");
+			CoalescedEvent(u32 mailbox = 0) : EventData(type_id), mailbox(mailbox) {}
+
+			u32 mailbox;
 		};
-		std::deque<ListenerQueue> queues;
-		std::mutex mutex;
-		std::shared_ptr<bool> alive;
 
-		friend class EventListener;
-	};
+		struct Mailbox
+		{
+			void Lock();
+			void Unlock();
+
+			std::atomic_flag lock;
+			bool pending = false;
+			// Ring position of the marker, no_position until its push went through
+			size_t position = no_position;
+			Event event;
+		};
 
-	struct Event
-	{
-	public:
-		Event() = default;
+		struct ListenerQueue
+		{
+			ListenerQueue(size_t capacity) : events(capacity) {}
 
-		operator bool() const;
-		bool Valid() const;
+			// Swaps a coalesced marker for the pending event it stands for
+			Event& Resolve(Event& event);
 
-		template<typename E>			E& get()		{ return *reinterpret_cast<E*>(data.get()); }
-		template<typename E>	const	E& get() const	{ return *reinterpret_cast<const E*>(data.get()); }
+			RingBuffer<Event> events;
+			std::array<Mailbox, max_coalesced_types> mailboxes;
+			std::atomic<size_t> dropped = 0;
+		};
 
-		Identifier ID() const;
-		bool IsType(const Identifier& type) const;
-		template<EventConcept E>
-		bool IsType() const
-		{ 
-			return IsType(E::type_id);
+		struct ListenerBlock
+		{
+			std::array<std::atomic<ListenerQueue*>, listener_block_size> slots = {};
+			std::atomic<ListenerBlock*> next = nullptr;
+		};
+
+		template<typename F>
+		void ForEachSlot(F&& function)
+		{
+			for (ListenerBlock* block = &listeners; block; block = block->next.load(std::memory_order_acquire))
+				for (auto& slot : block->slots)
+					function(slot);
 		}
 
-	private:
-		Event(std::unique_ptr<EventData>&& data);
-		std::unique_ptr<EventData> data;
+		static constexpr u32 no_mailbox = std::numeric_limits<u32>::max();
+
+		bool EnableCoalescing(const Identifier& type);
+		u32 FindMailbox(const Identifier& type) const;
+
+		void PostEvent(const Event& event);
+		void PostEvent(const Event& event, u32 mailbox, EventMergeFunction merge);
+		bool Push(std::atomic<ListenerQueue*>& slot, ListenerQueue& queue, const Event& event, size_t* position = nullptr);
+
+		size_t capacity;
+		EventOverflowPolicy overflow;
+		std::array<Identifier, max_coalesced_types> coalesced;
+		u32 coalescedCount = 0;
+		ListenerBlock listeners;
+		std::atomic<size_t> posting = 0;
+		std::mutex mutex;
+		std::shared_ptr<bool> alive;
 
 		friend class EventListener;
 	};
@@ -95,10 +223,28 @@ namespace rv
 		void StopListening();
 
 		Event GetEvent();
+		size_t GetEvents(std::span<Event> destination);
 		bool Empty() const;
+		size_t Dropped() const;
+
+		/*
+			Hands every pending event to function in the order they were posted.
+			Events posted while draining are left for the next call.
+		*/
+		template<typename F>
+		size_t DrainEvents(F&& function)
+		{
+			if (!events)
+				return 0;
+			const size_t count = events->events.size();
+			size_t drained = 0;
+			while (drained < count && events->events.consume([&](Event& event) { function(events->Resolve(event)); }))
+				++drained;
+			return drained;
+		}
 
 	private:
-		std::deque<EventQueue::ListenerQueue>::iterator events;
+		std::unique_ptr<EventQueue::ListenerQueue> events;
 		EventQueue* queue = nullptr;
 		std::shared_ptr<bool> alive;
 	};
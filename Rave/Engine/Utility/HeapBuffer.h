@@ -11,7 +11,7 @@ namespace rv
 		HeapBuffer(size_t size) : m_data(new T[size]), m_size(size) {}
 		HeapBuffer(const T* begin, const T* end) : m_data((end - begin > 0) ? new T[end - begin] : nullptr), m_size(end - begin) {}
 		HeapBuffer(const HeapBuffer& rhs) : m_data((rhs.size() > 0) ? new T[rhs.size()] : nullptr), m_size(rhs.size()) {}
-		HeapBuffer(HeapBuffer&& rhs) noexcept : m_data(rhs.data()), m_size(rhs.size) { rhs.m_data = nullptr, rhs.m_size = 0; }
+		HeapBuffer(HeapBuffer&& rhs) noexcept : m_data(rhs.data()), m_size(rhs.size()) { rhs.m_data = nullptr, rhs.m_size = 0; }
 		~HeapBuffer() { clear(); }
 
 		HeapBuffer& operator= (const HeapBuffer& rhs) 
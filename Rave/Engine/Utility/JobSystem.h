@@ -0,0 +1,109 @@
+#pragma once
+#include "Engine/Utility/Result.h"
+#include "Engine/Utility/Types.h"
+#include <functional>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+#include <deque>
+#include <memory>
+
+namespace rv
+{
+	class JobCounter;
+
+	namespace detail
+	{
+		struct Job
+		{
+			std::function<void()> function;
+			JobCounter* counter = nullptr;
+		};
+	}
+
+	/*
+		Counts the unfinished jobs it was passed to.
+		Jobs started with RunAfter are held back until it reaches zero.
+	*/
+	class JobCounter
+	{
+	public:
+		JobCounter() = default;
+		JobCounter(const JobCounter&) = delete;
+		JobCounter& operator= (const JobCounter&) = delete;
+
+		bool Done() const { return count.load(std::memory_order_acquire) == 0; }
+
+	private:
+		std::atomic<u32> count = 0;
+		std::mutex mutex;
+		std::vector<detail::Job> continuations;
+
+		friend class JobSystem;
+	};
+
+	/*
+		Every worker owns a deque: it pushes and pops at the back, idle workers steal from the front of the others.
+		Threads that aren't workers share queue 0. Wait runs jobs on the calling thread instead of blocking,
+		so waiting from inside a job can't deadlock. A JobSystem that hasn't been created runs every job inline.
+	*/
+	class JobSystem
+	{
+	public:
+		JobSystem() = default;
+		JobSystem(const JobSystem&) = delete;
+		~JobSystem();
+
+		JobSystem& operator= (const JobSystem&) = delete;
+
+		void Release();
+
+		// Starts nThreads workers next to the calling thread, 0 starts one for every other hardware thread
+		static Result Create(JobSystem& jobs, u32 nThreads = 0);
+
+		void Run(std::function<void()> job, JobCounter* counter = nullptr);
+		void RunAfter(JobCounter& dependency, std::function<void()> job, JobCounter* counter = nullptr);
+		void Wait(JobCounter& counter);
+
+		// Calls function(i) for every i in [begin, end), grain indices per job, and waits for all of them
+		template<typename F>
+		void ParallelFor(size_t begin, size_t end, size_t grain, F&& function)
+		{
+			if (begin >= end)
+				return;
+			grain = std::max<size_t>(grain, 1);
+			JobCounter counter;
+			for (size_t first = begin; first < end; first += grain)
+			{
+				const size_t last = std::min(first + grain, end);
+				Run([&function, first, last]() { for (size_t i = first; i < last; ++i) function(i); }, &counter);
+			}
+			Wait(counter);
+		}
+
+		// Workers plus the calling thread
+		u32 ThreadCount() const;
+
+	private:
+		struct Queue
+		{
+			std::mutex mutex;
+			std::deque<detail::Job> jobs;
+		};
+
+		void Push(detail::Job&& job);
+		bool Pop(detail::Job& job);
+		void Execute(detail::Job& job);
+		void Work(u32 index);
+
+		std::vector<std::unique_ptr<Queue>> queues;
+		std::vector<std::thread> workers;
+		std::atomic<size_t> pending = 0;
+		std::mutex sleepMutex;
+		std::condition_variable wake;
+		bool running = false;
+	};
+}
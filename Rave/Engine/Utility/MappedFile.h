@@ -0,0 +1,34 @@
+#pragma once
+#include "Engine/Utility/Result.h"
+#include "Engine/Utility/Types.h"
+#include <filesystem>
+
+namespace rv
+{
+	/*
+		Read-only mapping of a whole file, the data is paged in by the OS on first access instead of being copied.
+		Mappings start on a page boundary, so the data is aligned for any type (e.g. SPIR-V words).
+	*/
+	struct MappedFile
+	{
+		MappedFile() = default;
+		MappedFile(const MappedFile&) = delete;
+		MappedFile(MappedFile&& rhs) noexcept;
+		~MappedFile();
+
+		MappedFile& operator= (const MappedFile&) = delete;
+		MappedFile& operator= (MappedFile&& rhs) noexcept;
+
+		void Release();
+
+		static Result Create(MappedFile& file, const std::filesystem::path& path);
+
+		const u8* data = nullptr;
+		u64 size = 0;
+
+#	ifdef RV_PLATFORM_WINDOWS
+		void* file = nullptr;
+		void* mapping = nullptr;
+#	endif
+	};
+}
@@ -1,6 +1,10 @@
 #pragma once
 #include <stddef.h>
 #include <iterator>
+#include <vector>
+#include <memory>
+#include <typeinfo>
+#include <limits>
 #include "Engine/Utility/Hash.h"
 
 namespace rv
@@ -9,198 +13,188 @@ namespace rv
 	{
 	public:
 		MultiMap() = default;
-		MultiMap(const MultiMap& rhs);
+		MultiMap(const MultiMap&) = delete;
 		MultiMap(MultiMap&& rhs) noexcept;
 		~MultiMap();
 
+		MultiMap& operator= (const MultiMap&) = delete;
+		MultiMap& operator= (MultiMap&& rhs) noexcept;
 
-	private:
-		typedef void(*Destructor)(void*);
+		size_t size() const;
+		bool empty() const;
+		void clear();
+		void reserve(size_t count);
 
-		template<typename T>
-		static void make_destructor(void* object)
+	private:
+		static constexpr size_t page_size = 256;
+		static constexpr size_t min_capacity = 16;
+
+		/*
+			Values are kept per type in pages of page_size elements, so an element
+			never moves once it has been created and references returned by get() stay
+			valid until the element is erased.
+		*/
+		struct Storage
 		{
-			if (object)
-				reinterpret_cast<T*>(object)->~T();
-		}
+			Storage(size_t type) : type(type) {}
+			virtual ~Storage() = default;
 
-		struct SequentialHeader
-		{
-			SequentialHeader() = default;
-			~SequentialHeader();
+			virtual void destroy(u32 index) = 0;
+			virtual void destroy_all() = 0;
 
-			size_t type = 0;
-			Destructor destructor = nullptr;
-			SequentialHeader* next = nullptr;
+			size_t type;
+			std::vector<bool> alive;
+			std::vector<u32> free;
 		};
 
-		struct Header
-		{
-			Header() = default;
-			~Header();
-
-			size_t key = 0;
-			size_t type = 0;
-			Destructor destructor = nullptr;
-			Header* left = nullptr;
-			Header* right = nullptr;
-			SequentialHeader* next = nullptr;
-		};
 		template<typename T>
-		struct Entry
+		struct TypedStorage : public Storage
 		{
-			Entry(size_t key)
-				:
-				value()
+			struct alignas(T) Cell
+			{
+				unsigned char data[sizeof(T)];
+			};
+
+			TypedStorage() : Storage(typeid(T).hash_code()) {}
+			~TypedStorage() { destroy_all(); }
+
+			T* at(u32 index)
 			{
-				header.key = key;
-				header.type = typeid(T).hash_code();
-				if constexpr (std::is_class_v<T> || std::is_union_v<T>)
-				header.destructor = make_destructor<T>;
+				return reinterpret_cast<T*>(pages[index / page_size][index % page_size].data);
+			}
+
+			u32 create()
+			{
+				u32 index;
+				if (free.empty())
+				{
+					index = (u32)alive.size();
+					if (index % page_size == 0)
+						pages.emplace_back(new Cell[page_size]);
+					alive.push_back(true);
+				}
+				else
+				{
+					index = free.back();
+					free.pop_back();
+					alive[index] = true;
+				}
+				new (at(index)) T();
+				return index;
 			}
-			Entry(size_t key, const T& value)
-				:
-				value(value)
+
+			void destroy(u32 index) override
 			{
-				header.key = key;
-				header.type = typeid(T).hash_code();
-				if constexpr (std::is_class_v<T> || std::is_union_v<T>)
-				header.destructor = make_destructor<T>;
+				at(index)->~T();
+				alive[index] = false;
+				free.push_back(index);
 			}
-			Entry(size_t key, T&& value)
-				:
-				value(std::move(value))
+
+			void destroy_all() override
 			{
-				header.key = key;
-				header.type = typeid(T).hash_code();
-				if constexpr (std::is_class_v<T> || std::is_union_v<T>)
-				header.destructor = make_destructor<T>;
+				for (u32 i = 0; i < (u32)alive.size(); ++i)
+					if (alive[i])
+						at(i)->~T();
+				pages.clear();
+				alive.clear();
+				free.clear();
 			}
 
-			Header header;
-			T value;
+			std::vector<std::unique_ptr<Cell[]>> pages;
 		};
-		template<typename T>
-		struct SequentialEntry
+
+		struct Slot
 		{
-			SequentialHeader header;
-			T value;
+			size_t key = 0;
+			u32 storage = 0;
+			u32 index = 0;
+			bool used = false;
 		};
 
-		template<typename T>
-		static Entry<T>* as_entry(Header* header) { return reinterpret_cast<Entry<T>*>(header); }
-		template<typename T>
-		static const Entry<T>* as_entry(const Header* header) { return reinterpret_cast<Entry<T>*>(header); }
-
-		template<typename T>
-		static SequentialEntry<T>* as_entry(SequentialHeader* header) { return reinterpret_cast<SequentialEntry<T>*>(header); }
-		template<typename T>
-		static const SequentialEntry<T>* as_entry(const SequentialHeader* header) { return reinterpret_cast<SequentialEntry<T>*>(header); }
+		size_t home(size_t key) const { return key & (slots.size() - 1); }
 
 		template<typename T>
-		static T* data(Header* header)
+		u32 storage_index(bool create)
 		{
-			return reinterpret_cast<T*>(reinterpret_cast<unsigned char*>(header) + offsetof(Entry<T>, value));
+			const size_t type = typeid(T).hash_code();
+			for (u32 i = 0; i < (u32)storages.size(); ++i)
+				if (storages[i]->type == type)
+					return i;
+			if (!create)
+				return invalid_storage;
+			storages.emplace_back(new TypedStorage<T>());
+			return (u32)storages.size() - 1;
 		}
+
 		template<typename T>
-		static const T* data(const Header* header)
-		{
-			return reinterpret_cast<const T*>(reinterpret_cast<const unsigned char*>(header) + offsetof(Entry<T>, value));
-		}
-		template<>
-		static void* data(Header* header)
+		TypedStorage<T>* storage(u32 index)
 		{
-			return reinterpret_cast<void*>(reinterpret_cast<unsigned char*>(header) + sizeof(Header));
-		}
-		template<>
-		static const void* data(const Header* header)
-		{
-			return reinterpret_cast<const void*>(reinterpret_cast<const unsigned char*>(header) + sizeof(Header));
+			return static_cast<TypedStorage<T>*>(storages[index].get());
 		}
 
-		template<typename T = void>
-		static T* data(SequentialHeader* header)
-		{
-			return reinterpret_cast<T*>(reinterpret_cast<unsigned char*>(header) + offsetof(SequentialEntry<T>, value));
-		}
-		template<typename T = void>
-		static const T* data(const SequentialHeader* header)
+		size_t find_slot(size_t key, size_t type) const;
+		void insert_slot(size_t key, u32 storage, u32 index);
+		void erase_slot(size_t slot);
+		void rehash(size_t capacity);
+
+		std::vector<Slot> slots;
+		std::vector<std::unique_ptr<Storage>> storages;
+		size_t count = 0;
+
+		static constexpr size_t npos = std::numeric_limits<size_t>::max();
+		static constexpr u32 invalid_storage = std::numeric_limits<u32>::max();
+
+	public:
+		template<typename T, typename... K>
+		T& get(const K&... keys)
 		{
-			return reinterpret_cast<const T*>(reinterpret_cast<const unsigned char*>(header) + offsetof(SequentialEntry<T>, value));
+			const size_t key = hash(typeid(T).hash_code(), keys...);
+			const size_t slot = find_slot(key, typeid(T).hash_code());
+			if (slot != npos)
+				return *storage<T>(slots[slot].storage)->at(slots[slot].index);
+
+			const u32 s = storage_index<T>(true);
+			const u32 index = storage<T>(s)->create();
+			insert_slot(key, s, index);
+			return *storage<T>(s)->at(index);
 		}
-		template<>
-		static void* data(SequentialHeader* header)
+
+		template<typename T, typename... K>
+		T* find(const K&... keys)
 		{
-			return reinterpret_cast<void*>(reinterpret_cast<unsigned char*>(header) + sizeof(SequentialHeader));
+			const size_t slot = find_slot(hash(typeid(T).hash_code(), keys...), typeid(T).hash_code());
+			if (slot == npos)
+				return nullptr;
+			return storage<T>(slots[slot].storage)->at(slots[slot].index);
 		}
-		template<>
-		static const void* data(const SequentialHeader* header)
+
+		template<typename T, typename... K>
+		bool contains(const K&... keys) const
 		{
-			return reinterpret_cast<const void*>(reinterpret_cast<const unsigned char*>(header) + sizeof(SequentialHeader));
+			return find_slot(hash(typeid(T).hash_code(), keys...), typeid(T).hash_code()) != npos;
 		}
 
-		Header* get_header(size_t key);
-		const Header* get_header(size_t key) const;
-		Header* get_header_const(size_t key) const;
-
-		static void destroy(Header* header);
-		static void destroy(SequentialHeader* header);
-
-		Header* first = nullptr;
-
-
-	public:
 		template<typename T, typename... K>
-		T& get(const K&... keys)
+		bool erase(const K&... keys)
 		{
-			size_t key = hash(typeid(T).hash_code(), keys...);
-			Header* header = get_header(key);
-
-			if (header)
-			{
-				if (header->type == typeid(T).hash_code())
-					return *data<T>(header);
-				for (SequentialHeader* sequential = header->next; sequential; sequential = sequential->next)
-					if (sequential->type == typeid(T).hash_code())
-						return *data<T>(sequential);
-			}
+			const size_t slot = find_slot(hash(typeid(T).hash_code(), keys...), typeid(T).hash_code());
+			if (slot == npos)
+				return false;
+			storages[slots[slot].storage]->destroy(slots[slot].index);
+			erase_slot(slot);
+			return true;
+		}
 
-			if (first)
-			{
-				header = first;
-				while (true)
-				{
-					if (key < header->key)
-					{
-						if (header->left)
-						{
-							header = header->left;
-						}
-						else
-						{
-							header->left = reinterpret_cast<Header*>(new Entry<T>(key));
-							return *data<T>(header->left);
-						}
-					}
-					else
-					{
-						if (header->right)
-						{
-							header = header->right;
-						}
-						else
-						{
-							header->right = reinterpret_cast<Header*>(new Entry<T>(key));
-							return *data<T>(header->right);
-						}
-					}
-				}
-			}
-			else
-			{
-				first = reinterpret_cast<Header*>(new Entry<T>(key));
-				return *data<T>(first);
-			}
+		template<typename T, typename F>
+		void for_each(F&& function)
+		{
+			const u32 s = storage_index<T>(false);
+			if (s == invalid_storage)
+				return;
+			TypedStorage<T>* values = storage<T>(s);
+			for (u32 i = 0; i < (u32)values->alive.size(); ++i)
+				if (values->alive[i])
+					function(*values->at(i));
 		}
 	};
 }
\ No newline at end of file
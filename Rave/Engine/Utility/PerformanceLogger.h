@@ -1,15 +1,130 @@
 #pragma once
+#include "Engine/Core/CompileTimeInfo.h"
 #include "Engine/Utility/Timer.h"
 #include "Engine/Utility/Identifier.h"
+#include "Engine/Utility/RingBuffer.h"
 #include <vector>
 #include <queue>
+#include <mutex>
+#include <memory>
+#include <unordered_map>
 
 namespace rv
 {
+	struct PerformanceStatistics
+	{
+		Identifier name;
+		u64 frames = 0;
+		u64 calls = 0;
+		Duration min;
+		Duration avg;
+		Duration max;
+		Duration p99;
+	};
+
+	/*
+		Scopes are timed on the calling thread and pushed into a lock-free ring owned by that thread.
+		EndFrame collects every ring and keeps the time spent per scope per frame,
+		the statistics are computed over the last history_frames frames.
+	*/
 	class PerformanceLogger
 	{
 	public:
+		static constexpr size_t thread_capacity = 1 << 14;
+		static constexpr size_t history_frames = 1024;
+		static constexpr size_t max_trace_samples = 1 << 20;
+
+		class Scope
+		{
+		public:
+			Scope(const Identifier& name);
+			~Scope();
+
+			Scope(const Scope&) = delete;
+			Scope& operator= (const Scope&) = delete;
+
+		private:
+			Identifier name;
+			u64 start;
+		};
+
+		PerformanceLogger();
+		~PerformanceLogger();
+
+		void EndFrame();
+
+		PerformanceStatistics Statistics(const Identifier& name) const;
+		std::vector<PerformanceStatistics> Statistics() const;
+
+		// Writes every collected sample as Chrome trace-event JSON (chrome://tracing, Perfetto)
+		bool ExportChromeTrace(const char* filename) const;
+
+		// Keeps every sample for ExportChromeTrace, release builds have to opt in before the frames they want exported
+		bool tracing = CompileTimeInfo::build.debug;
 
 	private:
+		struct Sample
+		{
+			Identifier name;
+			u64 start = 0;
+			u64 end = 0;
+			u32 thread = 0;
+		};
+
+		struct ThreadBuffer
+		{
+			ThreadBuffer(u32 id) : samples(thread_capacity), id(id) {}
+
+			RingBuffer<Sample> samples;
+			std::atomic<u64> dropped = 0;
+			// Set when the owning thread exits, EndFrame collects the remaining samples and frees the buffer
+			std::atomic<bool> retired = false;
+			u32 id;
+		};
+
+		struct ScopeHistory
+		{
+			Identifier name;
+			u64 calls = 0;
+			u64 current = 0;
+			u32 currentCalls = 0;
+			std::vector<u64> frames;
+			size_t next = 0;
+		};
+
+		static u64 Now();
+		void Push(const Sample& sample);
+		ThreadBuffer& LocalBuffer();
+
+		std::vector<std::unique_ptr<ThreadBuffer>> threads;
+		u32 nextThread = 0;
+		std::mutex threadMutex;
+
+		std::unordered_map<size_t, ScopeHistory> scopes;
+		std::vector<Sample> trace;
+		u64 frame = 0;
+		u64 epoch;
+		mutable std::mutex mutex;
 	};
-}
\ No newline at end of file
+
+	extern PerformanceLogger performance;
+}
+
+#if defined(RV_PERFORMANCE_LOGGER) && defined(RV_NO_PERFORMANCE_LOGGER)
+#	error RV_PERFORMANCE_LOGGER and RV_NO_PERFORMANCE_LOGGER cannot both be defined
+#endif
+#ifndef RV_NO_PERFORMANCE_LOGGER
+#	define RV_PERFORMANCE_LOGGER
+#endif
+
+#define rv_performance_concat_impl(a, b)	a##b
+#define rv_performance_concat(a, b)			rv_performance_concat_impl(a, b)
+
+#ifdef RV_PERFORMANCE_LOGGER
+#define rv_performance_scope(name)			static constexpr rv::Identifier rv_performance_concat(rv_performance_id_, __LINE__) = rv::Identifier(name); \
+											rv::PerformanceLogger::Scope rv_performance_concat(rv_performance_scope_, __LINE__)(rv_performance_concat(rv_performance_id_, __LINE__))
+#define rv_performance_only(code)			code
+#else
+#define rv_performance_scope(name)
+#define rv_performance_only(code)
+#endif
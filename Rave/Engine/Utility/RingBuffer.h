@@ -0,0 +1,137 @@
+#pragma once
+#include <stddef.h>
+#include <atomic>
+#include <memory>
+#include <utility>
+#include <bit>
+
+namespace rv
+{
+	/*
+		Bounded lock-free queue (D. Vyukov's array queue).
+		Any number of threads may push and pop concurrently; push fails instead of
+		blocking when the buffer is full. The capacity is rounded up to a power of two.
+	*/
+	template<typename T>
+	class RingBuffer
+	{
+	public:
+		RingBuffer() = default;
+		RingBuffer(size_t capacity)
+		{
+			Reserve(capacity);
+		}
+		RingBuffer(const RingBuffer&) = delete;
+		RingBuffer& operator= (const RingBuffer&) = delete;
+
+		// Not thread safe, only call this before the buffer is shared.
+		void Reserve(size_t capacity)
+		{
+			capacity = std::bit_ceil(capacity < 2 ? 2 : capacity);
+			cells = std::make_unique<Cell[]>(capacity);
+			for (size_t i = 0; i < capacity; ++i)
+				cells[i].sequence.store(i, std::memory_order_relaxed);
+			mask = capacity - 1;
+			head.store(0, std::memory_order_relaxed);
+			tail.store(0, std::memory_order_relaxed);
+		}
+
+		template<typename U>
+		bool push(U&& value)
+		{
+			size_t position;
+			return push(std::forward<U>(value), position);
+		}
+
+		// position receives the index of the push, see pushed
+		template<typename U>
+		bool push(U&& value, size_t& position)
+		{
+			Cell* cell;
+			size_t pos = tail.load(std::memory_order_relaxed);
+			while (true)
+			{
+				cell = &cells[pos & mask];
+				const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+				const ptrdiff_t diff = (ptrdiff_t)sequence - (ptrdiff_t)pos;
+				if (diff == 0)
+				{
+					if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+						break;
+				}
+				else if (diff < 0)
+					return false;
+				else
+					pos = tail.load(std::memory_order_relaxed);
+			}
+			cell->value = std::forward<U>(value);
+			cell->sequence.store(pos + 1, std::memory_order_release);
+			position = pos;
+			return true;
+		}
+
+		bool pop(T& value)
+		{
+			return consume([&value](T& element) { value = std::move(element); });
+		}
+
+		// Pops one element and hands it to function while it is still in its cell, the cell keeps the used value until it is overwritten
+		template<typename F>
+		bool consume(F&& function)
+		{
+			Cell* cell;
+			size_t pos = head.load(std::memory_order_relaxed);
+			while (true)
+			{
+				cell = &cells[pos & mask];
+				const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+				const ptrdiff_t diff = (ptrdiff_t)sequence - (ptrdiff_t)(pos + 1);
+				if (diff == 0)
+				{
+					if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+						break;
+				}
+				else if (diff < 0)
+					return false;
+				else
+					pos = head.load(std::memory_order_relaxed);
+			}
+			function(cell->value);
+			cell->sequence.store(pos + mask + 1, std::memory_order_release);
+			return true;
+		}
+
+		// Only a snapshot while other threads are pushing or popping.
+		size_t size() const
+		{
+			const size_t t = tail.load(std::memory_order_acquire);
+			const size_t h = head.load(std::memory_order_acquire);
+			return t > h ? t - h : 0;
+		}
+		bool empty() const
+		{
+			return size() == 0;
+		}
+		// Pushes that claimed a cell so far, the element pushed at position is the newest while this is position + 1
+		size_t pushed() const
+		{
+			return tail.load(std::memory_order_acquire);
+		}
+		size_t capacity() const
+		{
+			return cells ? mask + 1 : 0;
+		}
+
+	private:
+		struct Cell
+		{
+			std::atomic<size_t> sequence;
+			T value;
+		};
+
+		std::unique_ptr<Cell[]> cells;
+		size_t mask = 0;
+		alignas(64) std::atomic<size_t> head = 0;
+		alignas(64) std::atomic<size_t> tail = 0;
+	};
+}
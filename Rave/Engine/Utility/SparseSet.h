@@ -0,0 +1,121 @@
+#pragma once
+#include "Engine/Utility/Types.h"
+#include <stddef.h>
+#include <vector>
+#include <limits>
+#include <utility>
+#include <new>
+
+namespace rv
+{
+	/*
+		Maps small integer ids to densely packed values.
+		Values are contiguous and can be iterated linearly; erasing moves the last
+		value into the freed spot, so pointers and indices into the dense array are
+		only stable until the next insertion or erasure.
+	*/
+	template<typename T>
+	class SparseSet
+	{
+	public:
+		static constexpr u32 invalid_index = std::numeric_limits<u32>::max();
+
+		SparseSet() = default;
+		SparseSet(const SparseSet&) = delete;
+		SparseSet(SparseSet&&) noexcept = default;
+
+		SparseSet& operator= (const SparseSet&) = delete;
+		SparseSet& operator= (SparseSet&&) noexcept = default;
+
+		T& get(u32 id)
+		{
+			if (id >= sparse.size())
+				sparse.resize((size_t)id + 1, invalid_index);
+			else if (sparse[id] != invalid_index)
+				return values[sparse[id]];
+
+			sparse[id] = (u32)values.size();
+			dense.push_back(id);
+			return values.emplace_back();
+		}
+
+		T* find(u32 id)
+		{
+			u32 i = index(id);
+			return i == invalid_index ? nullptr : &values[i];
+		}
+		const T* find(u32 id) const
+		{
+			u32 i = index(id);
+			return i == invalid_index ? nullptr : &values[i];
+		}
+
+		bool contains(u32 id) const
+		{
+			return index(id) != invalid_index;
+		}
+
+		bool erase(u32 id)
+		{
+			u32 i = index(id);
+			if (i == invalid_index)
+				return false;
+
+			u32 last = (u32)values.size() - 1;
+			if (i != last)
+			{
+				values[i].~T();
+				new (&values[i]) T(std::move(values[last]));
+				dense[i] = dense[last];
+				sparse[dense[i]] = i;
+			}
+			values.pop_back();
+			dense.pop_back();
+			sparse[id] = invalid_index;
+			return true;
+		}
+
+		void clear()
+		{
+			values.clear();
+			dense.clear();
+			sparse.clear();
+		}
+
+		void reserve(size_t count)
+		{
+			values.reserve(count);
+			dense.reserve(count);
+		}
+
+		u32 index(u32 id) const
+		{
+			return id < sparse.size() ? sparse[id] : invalid_index;
+		}
+		u32 id(u32 index) const
+		{
+			return dense[index];
+		}
+
+		size_t size() const { return values.size(); }
+		bool empty() const { return values.empty(); }
+
+				T* data()		{ return values.data(); }
+		const	T* data() const	{ return values.data(); }
+
+				T& operator[] (u32 index)		{ return values[index]; }
+		const	T& operator[] (u32 index) const	{ return values[index]; }
+
+		const std::vector<u32>& ids() const { return dense; }
+
+		auto begin()		{ return values.begin(); }
+		auto begin() const	{ return values.begin(); }
+		auto end()			{ return values.end(); }
+		auto end() const	{ return values.end(); }
+
+	private:
+		std::vector<u32> sparse;
+		std::vector<u32> dense;
+		std::vector<T> values;
+	};
+}
@@ -1,4 +1,5 @@
 #include "Engine/Utility/Event.h"
+#include <thread>
 
 rv::EventData::EventData(const Identifier& id)
 	:
@@ -6,8 +7,10 @@ rv::EventData::EventData(const Identifier& id)
 {
 }
 
-rv::EventQueue::EventQueue()
+rv::EventQueue::EventQueue(size_t capacity, EventOverflowPolicy overflow)
 	:
+	capacity(capacity),
+	overflow(overflow),
 	alive(std::make_shared<bool>(true))
 {
 }
@@ -15,15 +18,177 @@ rv::EventQueue::EventQueue()
 rv::EventQueue::~EventQueue()
 {
 	*alive = false;
+	for (ListenerBlock* block = listeners.next.load(std::memory_order_acquire); block; )
+	{
+		ListenerBlock* next = block->next.load(std::memory_order_acquire);
+		delete block;
+		block = next;
+	}
+}
+
+bool rv::EventQueue::EnableCoalescing(const Identifier& type)
+{
+	if (FindMailbox(type) != no_mailbox)
+		return true;
+	if (coalescedCount == max_coalesced_types)
+		return false;
+	coalesced[coalescedCount++] = type;
+	return true;
+}
+
+rv::u32 rv::EventQueue::FindMailbox(const Identifier& type) const
+{
+	for (u32 i = 0; i < coalescedCount; ++i)
+		if (coalesced[i] == type)
+			return i;
+	return no_mailbox;
+}
+
+void rv::EventQueue::PostEvent(const Event& event)
+{
+	posting.fetch_add(1, std::memory_order_seq_cst);
+	ForEachSlot([this, &event](std::atomic<ListenerQueue*>& slot) {
+		if (ListenerQueue* queue = slot.load(std::memory_order_seq_cst))
+			Push(slot, *queue, event);
+	});
+	posting.fetch_sub(1, std::memory_order_release);
 }
 
-void rv::EventQueue::PostEvent(EventData* event)
+void rv::EventQueue::PostEvent(const Event& event, u32 mailbox, EventMergeFunction merge)
 {
-	std::lock_guard<std::mutex> guard(mutex);
-	for (auto& queue : queues)
+	posting.fetch_add(1, std::memory_order_seq_cst);
+	ForEachSlot([this, &event, mailbox, merge](std::atomic<ListenerQueue*>& slot) {
+		ListenerQueue* queue = slot.load(std::memory_order_seq_cst);
+		if (!queue)
+			return;
+
+		Mailbox& box = queue->mailboxes[mailbox];
+		box.Lock();
+		// Merging into a marker that has other events behind it would move the event ahead of them
+		if (box.pending && box.position != no_position && box.position + 1 == queue->events.pushed())
+		{
+			merge(box.event, event);
+			box.Unlock();
+			return;
+		}
+		const bool start = !box.pending;
+		if (start)
+		{
+			box.event = event;
+			box.pending = true;
+			box.position = no_position;
+		}
+		box.Unlock();
+
+		// The pending event is behind other events now, this one keeps its own place until the listener resolves it
+		if (!start)
+		{
+			Push(slot, *queue, event);
+			return;
+		}
+
+		size_t position;
+		const bool pushed = Push(slot, *queue, Event(CoalescedEvent(mailbox)), &position);
+		box.Lock();
+		if (pushed)
+		{
+			// Unless the listener resolved the marker already
+			if (box.pending && box.position == no_position)
+				box.position = position;
+		}
+		else
+		{
+			// Nothing merges before the position is known, so the payload only holds this event and is dropped with it
+			box.pending = false;
+			box.event.Release();
+		}
+		box.Unlock();
+	});
+	posting.fetch_sub(1, std::memory_order_release);
+}
+
+bool rv::EventQueue::Push(std::atomic<ListenerQueue*>& slot, ListenerQueue& queue, const Event& event, size_t* position)
+{
+	size_t pushed;
+	while (!queue.events.push(event, pushed))
 	{
-		queue.events.emplace_back(event);
+		// A listener that stops listening clears its slot first, so a blocked post can't outlive it
+		if (overflow == RV_EVENT_OVERFLOW_DROP || slot.load(std::memory_order_acquire) != &queue)
+		{
+			queue.dropped.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+		std::this_thread::yield();
 	}
+	if (position)
+		*position = pushed;
+	return true;
+}
+
+void rv::EventQueue::Mailbox::Lock()
+{
+	while (lock.test_and_set(std::memory_order_acquire))
+		std::this_thread::yield();
+}
+
+void rv::EventQueue::Mailbox::Unlock()
+{
+	lock.clear(std::memory_order_release);
+}
+
+rv::Event& rv::EventQueue::ListenerQueue::Resolve(Event& event)
+{
+	if (!event.IsType(CoalescedEvent::type_id))
+		return event;
+
+	Mailbox& box = mailboxes[event.get<CoalescedEvent>().mailbox];
+	box.Lock();
+	event = std::move(box.event);
+	box.pending = false;
+	box.Unlock();
+	return event;
+}
+
+rv::Event::Event(const Event& rhs)
+	:
+	functions(rhs.functions)
+{
+	if (functions)
+		functions->copy(data, rhs.data);
+}
+
+rv::Event::Event(Event&& rhs) noexcept
+	:
+	Event(static_cast<const Event&>(rhs))
+{
+	rhs.Release();
+}
+
+rv::Event::~Event()
+{
+	Release();
+}
+
+rv::Event& rv::Event::operator=(const Event& rhs)
+{
+	if (this != &rhs)
+	{
+		Release();
+		functions = rhs.functions;
+		if (functions)
+			functions->copy(data, rhs.data);
+	}
+	return *this;
+}
+
+rv::Event& rv::Event::operator=(Event&& rhs) noexcept
+{
+	if (this != &rhs)
+	{
+		*this = static_cast<const Event&>(rhs);
+		rhs.Release();
+	}
+	return *this;
 }
 
 rv::Event::operator bool() const
@@ -33,24 +198,26 @@ rv::Event::operator bool() const
 
 bool rv::Event::Valid() const 
 { 
-	return data.get(); 
+	return functions; 
+}
+
+void rv::Event::Release()
+{
+	if (functions)
+		functions->destroy(data);
+	functions = nullptr;
 }
 
 rv::Identifier rv::Event::ID() const
 { 
-	return data->id; 
+	return functions->base(data).id;
 }
 
 bool rv::Event::IsType(const Identifier& type) const
 {
-	return data->id == type;
+	return functions->base(data).id == type;
 }
 
-rv::Event::Event(std::unique_ptr<EventData>&& data) 
-	: 
-	data(std::move(data)) 
-{}
-
 rv::EventListener::EventListener(EventQueue& queue)
 {
 	Listen(queue);
@@ -63,16 +230,39 @@ rv::EventListener::~EventListener()
 
 bool rv::EventListener::Active() const
 {
-	return queue && events != queue->queues.end() && alive.get() && *alive;
+	return queue && events && alive.get() && *alive;
 }
 
 void rv::EventListener::Listen(EventQueue& queue)
 {
 	StopListening();
-	this->queue = &queue;
 	std::lock_guard<std::mutex> guard(queue.mutex);
-	queue.queues.emplace_back();
-	events = queue.queues.end() - 1;
+	std::atomic<EventQueue::ListenerQueue*>* free = nullptr;
+	EventQueue::ListenerBlock* last = nullptr;
+	for (EventQueue::ListenerBlock* block = &queue.listeners; block && !free; block = block->next.load(std::memory_order_relaxed))
+	{
+		last = block;
+		for (auto& slot : block->slots)
+		{
+			if (!slot.load(std::memory_order_relaxed))
+			{
+				free = &slot;
+				break;
+			}
+		}
+	}
+
+	if (!free)
+	{
+		// Posts walking the chain see the new block once it is linked, its slots are already empty
+		EventQueue::ListenerBlock* block = new EventQueue::ListenerBlock;
+		last->next.store(block, std::memory_order_release);
+		free = &block->slots[0];
+	}
+
+	events = std::make_unique<EventQueue::ListenerQueue>(queue.capacity);
+	free->store(events.get(), std::memory_order_seq_cst);
+	this->queue = &queue;
 	alive = queue.alive;
 }
 
@@ -81,29 +271,50 @@ void rv::EventListener::StopListening()
 	if (Active())
 	{
 		std::lock_guard<std::mutex> guard(queue->mutex);
-		queue->queues.erase(events);
+		queue->ForEachSlot([this](std::atomic<EventQueue::ListenerQueue*>& slot) {
+			if (slot.load(std::memory_order_relaxed) == events.get())
+				slot.store(nullptr, std::memory_order_seq_cst);
+		});
 
-		queue = nullptr;
-		events = {};
-		alive.reset();
+		// Wait for posts that may still hold the old slot value
+		while (queue->posting.load(std::memory_order_seq_cst))
+			std::this_thread::yield();
 	}
+	queue = nullptr;
+	events.reset();
+	alive.reset();
 }
 
 rv::Event rv::EventListener::GetEvent()
 {
-	if (!Active())
+	if (!events)
 		return {};
-	std::lock_guard<std::mutex> guard(queue->mutex);
-	if (events->events.empty())
-		return {};
-	std::unique_ptr<EventData> event = std::move(events->events.back());
-	events->events.pop_back();
+	Event event;
+	if (events->events.pop(event))
+		events->Resolve(event);
 	return event;
 }
 
+size_t rv::EventListener::GetEvents(std::span<Event> destination)
+{
+	if (!events)
+		return 0;
+	size_t count = 0;
+	while (count < destination.size() && events->events.pop(destination[count]))
+		events->Resolve(destination[count++]);
+	return count;
+}
+
 bool rv::EventListener::Empty() const
 {
-	if (Active())
+	if (events)
 		return events->events.empty();
 	return false;
 }
+
+size_t rv::EventListener::Dropped() const
+{
+	if (events)
+		return events->dropped.load(std::memory_order_relaxed);
+	return 0;
+}
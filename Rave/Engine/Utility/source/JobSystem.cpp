@@ -0,0 +1,182 @@
+#include "Engine/Utility/JobSystem.h"
+
+static thread_local rv::JobSystem* current_system = nullptr;
+static thread_local rv::u32 current_queue = 0;
+
+rv::JobSystem::~JobSystem()
+{
+	Release();
+}
+
+void rv::JobSystem::Release()
+{
+	{
+		std::lock_guard guard(sleepMutex);
+		running = false;
+	}
+	wake.notify_all();
+	for (auto& worker : workers)
+		worker.join();
+	workers.clear();
+
+	// Nothing is left to run them, finish whatever is still queued here
+	detail::Job job;
+	while (Pop(job))
+		Execute(job);
+	queues.clear();
+}
+
+rv::Result rv::JobSystem::Create(JobSystem& jobs, u32 nThreads)
+{
+	jobs.Release();
+	if (nThreads == 0)
+		nThreads = std::max(std::thread::hardware_concurrency(), 1u) - 1;
+
+	jobs.queues.resize((size_t)nThreads + 1);
+	for (auto& queue : jobs.queues)
+		queue = std::make_unique<Queue>();
+
+	jobs.running = true;
+	jobs.workers.reserve(nThreads);
+	for (u32 i = 1; i <= nThreads; ++i)
+		jobs.workers.emplace_back(&JobSystem::Work, &jobs, i);
+	return success;
+}
+
+void rv::JobSystem::Run(std::function<void()> job, JobCounter* counter)
+{
+	if (counter)
+		counter->count.fetch_add(1, std::memory_order_relaxed);
+	detail::Job j{ std::move(job), counter };
+	if (queues.empty())
+		Execute(j);
+	else
+		Push(std::move(j));
+}
+
+void rv::JobSystem::RunAfter(JobCounter& dependency, std::function<void()> job, JobCounter* counter)
+{
+	if (counter)
+		counter->count.fetch_add(1, std::memory_order_relaxed);
+	detail::Job j{ std::move(job), counter };
+	{
+		std::lock_guard guard(dependency.mutex);
+		if (!dependency.Done())
+		{
+			dependency.continuations.push_back(std::move(j));
+			return;
+		}
+	}
+	if (queues.empty())
+		Execute(j);
+	else
+		Push(std::move(j));
+}
+
+void rv::JobSystem::Wait(JobCounter& counter)
+{
+	while (!counter.Done())
+	{
+		detail::Job job;
+		if (Pop(job))
+			Execute(job);
+		else
+			std::this_thread::yield();
+	}
+	// The last job may still be holding the mutex, the counter can't be destroyed before it lets go
+	std::lock_guard guard(counter.mutex);
+}
+
+rv::u32 rv::JobSystem::ThreadCount() const
+{
+	return (u32)workers.size() + 1;
+}
+
+void rv::JobSystem::Push(detail::Job&& job)
+{
+	const u32 index = current_system == this ? current_queue : 0;
+	{
+		std::lock_guard guard(queues[index]->mutex);
+		queues[index]->jobs.push_back(std::move(job));
+	}
+	pending.fetch_add(1, std::memory_order_release);
+	{
+		// Taking the lock orders the notify after a worker's check of pending
+		std::lock_guard guard(sleepMutex);
+	}
+	wake.notify_one();
+}
+
+bool rv::JobSystem::Pop(detail::Job& job)
+{
+	if (queues.empty() || pending.load(std::memory_order_acquire) == 0)
+		return false;
+
+	const u32 index = current_system == this ? current_queue : 0;
+	{
+		Queue& own = *queues[index];
+		std::lock_guard guard(own.mutex);
+		if (!own.jobs.empty())
+		{
+			job = std::move(own.jobs.back());
+			own.jobs.pop_back();
+			pending.fetch_sub(1, std::memory_order_relaxed);
+			return true;
+		}
+	}
+	for (size_t i = 1; i < queues.size(); ++i)
+	{
+		Queue& victim = *queues[(index + i) % queues.size()];
+		std::lock_guard guard(victim.mutex);
+		if (!victim.jobs.empty())
+		{
+			job = std::move(victim.jobs.front());
+			victim.jobs.pop_front();
+			pending.fetch_sub(1, std::memory_order_relaxed);
+			return true;
+		}
+	}
+	return false;
+}
+
+void rv::JobSystem::Execute(detail::Job& job)
+{
+	job.function();
+	JobCounter* counter = job.counter;
+	if (!counter)
+		return;
+
+	std::vector<detail::Job> continuations;
+	{
+		std::lock_guard guard(counter->mutex);
+		if (counter->count.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			continuations.swap(counter->continuations);
+	}
+	for (auto& continuation : continuations)
+	{
+		if (queues.empty())
+			Execute(continuation);
+		else
+			Push(std::move(continuation));
+	}
+}
+
+void rv::JobSystem::Work(u32 index)
+{
+	current_system = this;
+	current_queue = index;
+	while (true)
+	{
+		detail::Job job;
+		if (Pop(job))
+		{
+			Execute(job);
+			continue;
+		}
+
+		std::unique_lock lock(sleepMutex);
+		wake.wait(lock, [this]() { return !running || pending.load(std::memory_order_acquire) > 0; });
+		if (!running && pending.load(std::memory_order_acquire) == 0)
+			break;
+	}
+}
@@ -0,0 +1,121 @@
+#include "Engine/Utility/MappedFile.h"
+#include "Engine/Utility/Error.h"
+#include "Engine/Utility/String.h"
+#ifdef RV_PLATFORM_WINDOWS
+#	include "Engine/Core/SystemInclude.h"
+#else
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <fcntl.h>
+#	include <unistd.h>
+#endif
+
+rv::MappedFile::MappedFile(MappedFile&& rhs) noexcept
+	:
+	data(rhs.data),
+	size(rhs.size)
+#	ifdef RV_PLATFORM_WINDOWS
+	,
+	file(move(rhs.file)),
+	mapping(move(rhs.mapping))
+#	endif
+{
+	rhs.data = nullptr;
+	rhs.size = 0;
+}
+
+rv::MappedFile::~MappedFile()
+{
+	Release();
+}
+
+rv::MappedFile& rv::MappedFile::operator=(MappedFile&& rhs) noexcept
+{
+	Release();
+	data = rhs.data;
+	size = rhs.size;
+#	ifdef RV_PLATFORM_WINDOWS
+	file = move(rhs.file);
+	mapping = move(rhs.mapping);
+#	endif
+	rhs.data = nullptr;
+	rhs.size = 0;
+	return *this;
+}
+
+void rv::MappedFile::Release()
+{
+#	ifdef RV_PLATFORM_WINDOWS
+	if (data)
+		UnmapViewOfFile(data);
+	if (mapping)
+		CloseHandle(mapping);
+	if (file)
+		CloseHandle(file);
+	mapping = nullptr;
+	file = nullptr;
+#	else
+	if (data)
+		munmap(const_cast<u8*>(data), size);
+#	endif
+	data = nullptr;
+	size = 0;
+}
+
+rv::Result rv::MappedFile::Create(MappedFile& file, const std::filesystem::path& path)
+{
+	file.Release();
+
+#	ifdef RV_PLATFORM_WINDOWS
+	HANDLE handle = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (handle == INVALID_HANDLE_VALUE)
+		return rv_runtime_error(str("Unable to open \"", path.string(), "\""));
+	file.file = handle;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(handle, &size))
+	{
+		file.Release();
+		return rv_runtime_error(str("Unable to get the size of \"", path.string(), "\""));
+	}
+	// Empty files can't be mapped
+	if (size.QuadPart == 0)
+		return success;
+
+	file.mapping = CreateFileMappingW(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (file.mapping)
+		file.data = (const u8*)MapViewOfFile(file.mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!file.data)
+	{
+		file.Release();
+		return rv_runtime_error(str("Unable to map \"", path.string(), "\""));
+	}
+	file.size = (u64)size.QuadPart;
+#	else
+	int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return rv_runtime_error(str("Unable to open \"", path.string(), "\""));
+
+	struct stat info;
+	if (fstat(fd, &info) != 0)
+	{
+		close(fd);
+		return rv_runtime_error(str("Unable to get the size of \"", path.string(), "\""));
+	}
+	// Empty files can't be mapped
+	if (info.st_size == 0)
+	{
+		close(fd);
+		return success;
+	}
+
+	// The mapping keeps the file alive, the descriptor isn't needed anymore
+	void* map = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED)
+		return rv_runtime_error(str("Unable to map \"", path.string(), "\""));
+	file.data = (const u8*)map;
+	file.size = (u64)info.st_size;
+#	endif
+	return success;
+}
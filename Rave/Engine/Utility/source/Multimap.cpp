@@ -1,85 +1,110 @@
 #include "Engine/Utility/Multimap.h"
 
-rv::MultiMap::MultiMap(const MultiMap& rhs)
-{
-}
-
 rv::MultiMap::MultiMap(MultiMap&& rhs) noexcept
 	:
-	first(rhs.first)
+	slots(std::move(rhs.slots)),
+	storages(std::move(rhs.storages)),
+	count(rhs.count)
 {
-	rhs.first = nullptr;
+	rhs.count = 0;
 }
 
 rv::MultiMap::~MultiMap()
 {
-	if (first)
-	{
-		destroy(first);
-		delete first;
-	}
+	clear();
 }
 
-rv::MultiMap::Header* rv::MultiMap::get_header(size_t key)
+rv::MultiMap& rv::MultiMap::operator=(MultiMap&& rhs) noexcept
 {
-	return get_header_const(key);
+	clear();
+	slots = std::move(rhs.slots);
+	storages = std::move(rhs.storages);
+	count = rhs.count;
+	rhs.count = 0;
+	return *this;
 }
 
-const rv::MultiMap::Header* rv::MultiMap::get_header(size_t key) const
+size_t rv::MultiMap::size() const
 {
-	return get_header_const(key);
+	return count;
 }
 
-rv::MultiMap::Header* rv::MultiMap::get_header_const(size_t key) const
+bool rv::MultiMap::empty() const
 {
-	for (Header* header = first; header; )
-	{
-		if (key < header->key)
-			header = header->left;
-		else if (key > header->key)
-			header = header->right;
-		else
-			return header;
-	}
-	return nullptr;
+	return count == 0;
 }
 
-void rv::MultiMap::destroy(Header* header)
+void rv::MultiMap::clear()
 {
-	if (header)
-	{
-		if (header->destructor)
-			header->destructor(data<void>(header));
-		destroy(header->next);
-		destroy(header->left);
-		destroy(header->right);
-	}
+	for (auto& storage : storages)
+		storage->destroy_all();
+	storages.clear();
+	slots.clear();
+	count = 0;
 }
 
-void rv::MultiMap::destroy(SequentialHeader* header)
+void rv::MultiMap::reserve(size_t n)
 {
-	if (header)
-	{
-		if (header->destructor)
-			header->destructor(data(header));
-		destroy(header->next);
-	}
+	size_t capacity = min_capacity;
+	while (capacity * 3 < n * 4)
+		capacity *= 2;
+	if (capacity > slots.size())
+		rehash(capacity);
+}
+
+size_t rv::MultiMap::find_slot(size_t key, size_t type) const
+{
+	if (slots.empty())
+		return npos;
+
+	const size_t mask = slots.size() - 1;
+	for (size_t i = home(key); slots[i].used; i = (i + 1) & mask)
+		if (slots[i].key == key && storages[slots[i].storage]->type == type)
+			return i;
+	return npos;
 }
 
-rv::MultiMap::Header::~Header()
+void rv::MultiMap::insert_slot(size_t key, u32 storage, u32 index)
 {
-	if (next)
-		delete next;
+	if ((count + 1) * 4 > slots.size() * 3)
+		rehash(slots.empty() ? min_capacity : slots.size() * 2);
 
-	if (left)
-		delete left;
+	const size_t mask = slots.size() - 1;
+	size_t i = home(key);
+	while (slots[i].used)
+		i = (i + 1) & mask;
 
-	if (right)
-		delete right;
+	slots[i].key = key;
+	slots[i].storage = storage;
+	slots[i].index = index;
+	slots[i].used = true;
+	++count;
+}
+
+void rv::MultiMap::erase_slot(size_t slot)
+{
+	// backward shift deletion keeps probe sequences intact without tombstones
+	const size_t mask = slots.size() - 1;
+	size_t hole = slot;
+	for (size_t i = (slot + 1) & mask; slots[i].used; i = (i + 1) & mask)
+	{
+		const size_t h = home(slots[i].key);
+		if (((i - h) & mask) >= ((i - hole) & mask))
+		{
+			slots[hole] = slots[i];
+			hole = i;
+		}
+	}
+	slots[hole] = Slot();
+	--count;
 }
 
-rv::MultiMap::SequentialHeader::~SequentialHeader()
+void rv::MultiMap::rehash(size_t capacity)
 {
-	if (next)
-		delete next;
+	std::vector<Slot> old = std::move(slots);
+	slots = std::vector<Slot>(capacity);
+	count = 0;
+	for (const Slot& slot : old)
+		if (slot.used)
+			insert_slot(slot.key, slot.storage, slot.index);
 }
@@ -0,0 +1,164 @@
+#include "Engine/Utility/PerformanceLogger.h"
+#include <algorithm>
+#include <fstream>
+#include <chrono>
+
+rv::PerformanceLogger rv::performance;
+
+rv::PerformanceLogger::Scope::Scope(const Identifier& name)
+	:
+	name(name),
+	start(Now())
+{
+}
+
+rv::PerformanceLogger::Scope::~Scope()
+{
+	Sample sample;
+	sample.name = name;
+	sample.start = start;
+	sample.end = Now();
+	performance.Push(sample);
+}
+
+rv::PerformanceLogger::PerformanceLogger()
+	:
+	epoch(Now())
+{
+}
+
+rv::PerformanceLogger::~PerformanceLogger()
+{
+}
+
+rv::u64 rv::PerformanceLogger::Now()
+{
+	return (u64)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+rv::PerformanceLogger::ThreadBuffer& rv::PerformanceLogger::LocalBuffer()
+{
+	// Retires the buffer when the thread exits, the logger still owns it until its samples are collected
+	struct Local
+	{
+		~Local() { if (buffer) buffer->retired.store(true, std::memory_order_release); }
+		ThreadBuffer* buffer = nullptr;
+	};
+	thread_local Local local;
+	if (!local.buffer)
+	{
+		std::lock_guard guard(threadMutex);
+		threads.emplace_back(std::make_unique<ThreadBuffer>(nextThread++));
+		local.buffer = threads.back().get();
+	}
+	return *local.buffer;
+}
+
+void rv::PerformanceLogger::Push(const Sample& sample)
+{
+	ThreadBuffer& buffer = LocalBuffer();
+	Sample s = sample;
+	s.thread = buffer.id;
+	if (!buffer.samples.push(s))
+		buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+void rv::PerformanceLogger::EndFrame()
+{
+	std::lock_guard guard(mutex);
+	{
+		std::lock_guard threadGuard(threadMutex);
+		Sample sample;
+		for (auto& thread : threads)
+		{
+			// Read before draining, a retired thread has finished pushing
+			const bool retired = thread->retired.load(std::memory_order_acquire);
+			while (thread->samples.pop(sample))
+			{
+				ScopeHistory& scope = scopes[sample.name.hash()];
+				scope.name = sample.name;
+				scope.current += sample.end - sample.start;
+				++scope.currentCalls;
+				if (tracing && trace.size() < max_trace_samples)
+					trace.push_back(sample);
+			}
+			if (retired)
+				thread.reset();
+		}
+		threads.erase(std::remove(threads.begin(), threads.end(), nullptr), threads.end());
+	}
+
+	for (auto& [hash, scope] : scopes)
+	{
+		if (scope.frames.size() < history_frames)
+			scope.frames.push_back(scope.current);
+		else
+			scope.frames[scope.next] = scope.current;
+		scope.next = (scope.next + 1) % history_frames;
+		scope.calls += scope.currentCalls;
+		scope.current = 0;
+		scope.currentCalls = 0;
+	}
+	++frame;
+}
+
+static rv::PerformanceStatistics make_statistics(const rv::Identifier& name, rv::u64 calls, std::vector<rv::u64> frames)
+{
+	rv::PerformanceStatistics statistics;
+	statistics.name = name;
+	statistics.calls = calls;
+	statistics.frames = frames.size();
+	if (frames.empty())
+		return statistics;
+
+	std::sort(frames.begin(), frames.end());
+	rv::u64 total = 0;
+	for (rv::u64 time : frames)
+		total += time;
+	statistics.min = std::chrono::duration<rv::u64, std::nano>(frames.front());
+	statistics.max = std::chrono::duration<rv::u64, std::nano>(frames.back());
+	statistics.avg = std::chrono::duration<rv::u64, std::nano>(total / frames.size());
+	statistics.p99 = std::chrono::duration<rv::u64, std::nano>(frames[std::min(frames.size() - 1, frames.size() * 99 / 100)]);
+	return statistics;
+}
+
+rv::PerformanceStatistics rv::PerformanceLogger::Statistics(const Identifier& name) const
+{
+	std::lock_guard guard(mutex);
+	auto it = scopes.find(name.hash());
+	if (it == scopes.end())
+		return make_statistics(name, 0, {});
+	return make_statistics(it->second.name, it->second.calls, it->second.frames);
+}
+
+std::vector<rv::PerformanceStatistics> rv::PerformanceLogger::Statistics() const
+{
+	std::lock_guard guard(mutex);
+	std::vector<PerformanceStatistics> statistics;
+	statistics.reserve(scopes.size());
+	for (const auto& [hash, scope] : scopes)
+		statistics.push_back(make_statistics(scope.name, scope.calls, scope.frames));
+	return statistics;
+}
+
+bool rv::PerformanceLogger::ExportChromeTrace(const char* filename) const
+{
+	std::ofstream file(filename);
+	if (!file.is_open())
+		return false;
+
+	std::lock_guard guard(mutex);
+	file << "{\"traceEvents\":[";
+	bool first = true;
+	for (const auto& sample : trace)
+	{
+		if (!first)
+			file << ',';
+		first = false;
+		file << "\n{\"name\":\"" << (sample.name.name() ? sample.name.name() : "?") << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << sample.thread
+			<< ",\"ts\":" << (double)(sample.start - epoch) / 1000.0
+			<< ",\"dur\":" << (double)(sample.end - sample.start) / 1000.0 << '}';
+	}
+	file << "\n],\"displayTimeUnit\":\"ms\"}\n";
+	return file.good();
+}
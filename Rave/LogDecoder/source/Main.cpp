@@ -0,0 +1,38 @@
+#include "Engine/Core/LogRecord.h"
+#include <iostream>
+#include <fstream>
+
+// Turns a binary log written by rv_logf back into the text layout of rv::Message::format
+int main(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		std::cerr << "Usage: LogDecoder <log.bin> [output.txt]\n";
+		return EXIT_FAILURE;
+	}
+
+	rv::BinaryLogReader reader;
+	if (!reader.Open(argv[1]))
+	{
+		std::cerr << "Unable to read binary log '" << argv[1] << "'\n";
+		return EXIT_FAILURE;
+	}
+
+	std::ofstream file;
+	if (argc > 2)
+	{
+		file.open(argv[2]);
+		if (!file.is_open())
+		{
+			std::cerr << "Unable to open output file '" << argv[2] << "'\n";
+			return EXIT_FAILURE;
+		}
+	}
+	std::ostream& output = file.is_open() ? file : std::cout;
+
+	rv::LogRecord record;
+	while (reader.Next(record))
+		output << rv::FormatLogMessage(record.severity, reader.Header().Time(record.ticks), record.Format()) << '\n';
+
+	return EXIT_SUCCESS;
+}
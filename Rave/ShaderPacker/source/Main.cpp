@@ -0,0 +1,93 @@
+#include "Engine/Graphics/ShaderArchive.h"
+#include "Engine/Utility/Error.h"
+#include <iostream>
+#include <fstream>
+
+static bool ReadFile(const std::filesystem::path& path, std::vector<rv::u8>& data)
+{
+	std::ifstream file(path, std::ios::binary | std::ios::ate);
+	if (!file.is_open())
+		return false;
+	data.resize((size_t)file.tellg());
+	file.seekg(0);
+	file.read(reinterpret_cast<char*>(data.data()), data.size());
+	return (bool)file;
+}
+
+// Packs every shader source in a directory into one archive, only sources whose content changed since the last pack are compiled again
+int main(int argc, char** argv)
+{
+	if (argc < 3)
+	{
+		std::cerr << "Usage: ShaderPacker <source directory> <archive.rvsa>\n";
+		return EXIT_FAILURE;
+	}
+
+	const std::filesystem::path sources = argv[1];
+	const std::filesystem::path output = argv[2];
+	if (!std::filesystem::is_directory(sources))
+	{
+		std::cerr << "'" << argv[1] << "' isn't a directory\n";
+		return EXIT_FAILURE;
+	}
+
+	// A missing or invalid archive just means everything gets compiled
+	rv::ShaderArchive previous;
+	if (std::filesystem::exists(output))
+		rv::ShaderArchive::Create(previous, output);
+
+	std::vector<rv::ShaderArchive::File> files;
+	size_t compiled = 0;
+	for (const auto& entry : std::filesystem::directory_iterator(sources))
+	{
+		if (!entry.is_regular_file())
+			continue;
+		const std::string filename = entry.path().filename().string();
+		if (rv::Shader::GetShaderTypeFromFile(filename.c_str()) == rv::RV_ST_NULL)
+			continue;
+
+		std::vector<rv::u8> source;
+		if (!ReadFile(entry.path(), source))
+		{
+			std::cerr << "Unable to read '" << entry.path().string() << "'\n";
+			return EXIT_FAILURE;
+		}
+
+		rv::ShaderArchive::File file;
+		file.name = rv::Shader::NormalizeName(filename);
+		file.source = rv::ShaderArchive::HashSource(source.data(), source.size());
+
+		const rv::ShaderArchive::Entry* old = previous.Find(file.name.c_str());
+		if (old && old->source == file.source)
+		{
+			const rv::u8* code = previous.Code(*old);
+			file.code.assign(code, code + old->codeSize);
+		}
+		else
+		{
+			const std::filesystem::path spirv = std::filesystem::temp_directory_path() / (file.name + ".spv");
+			if (rv::Shader::Compile(entry.path().string().c_str(), spirv.string().c_str()).failed() || !ReadFile(spirv, file.code))
+			{
+				std::cerr << "Unable to compile '" << entry.path().string() << "'\n";
+				return EXIT_FAILURE;
+			}
+			std::filesystem::remove(spirv);
+			++compiled;
+		}
+		files.push_back(std::move(file));
+	}
+
+	// The old archive can't be replaced while it's still mapped
+	previous.Release();
+
+	const size_t count = files.size();
+	rv::Result result = rv::ShaderArchive::Write(output, std::move(files));
+	if (result.failed())
+	{
+		std::cerr << "Unable to write '" << argv[2] << "'\n";
+		return EXIT_FAILURE;
+	}
+
+	std::cout << "Packed " << count << " shaders into '" << argv[2] << "', " << compiled << " compiled and " << (count - compiled) << " unchanged\n";
+	return EXIT_SUCCESS;
+}